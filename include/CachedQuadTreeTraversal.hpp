@@ -0,0 +1,196 @@
+#ifndef RW_CUBE_CACHED_QUAD_TREE_TRAVERSAL_HPP
+#define RW_CUBE_CACHED_QUAD_TREE_TRAVERSAL_HPP
+
+#include <cinttypes>
+#include <limits>
+#include <queue>
+#include <span>
+#include <vector>
+
+#include <PseudoQuadTree.hpp>
+
+namespace rw_cube {
+
+// visible set kept between frames; the frontier where the last traversal stopped (rejected nodes,
+// INSIDE nodes and accepted leaf level nodes) is stored with the motion each classification holds for,
+// update re-evaluates only frontier nodes whose margin the accumulated motion has used up and
+// reports leaves which entered or left the visible set since the previous update;
+// predicate returns StableContainment and must not accept a node whose parent it rejects
+template<
+    typename T,
+    std::uint8_t Height = DYNAMIC_TREE_HEIGHT,
+    std::uint8_t Dimensions = QUAD_TREE_DIMENSIONS>
+struct CachedQuadTreeTraversal {
+    using Tree = PseudoQuadTree<T, Height, Dimensions>;
+    using Leaf = typename Tree::Leaf;
+    // index into tree.leaves()
+    using LeafIndex = std::uint32_t;
+
+    static constexpr LeafIndex NOT_VISIBLE{ std::numeric_limits<LeafIndex>::max() };
+
+    // refined frontier is rebuilt from the root once it grows past this many times its rebuilt size,
+    // nodes it refined are never merged back otherwise
+    static constexpr std::size_t REBUILD_GROWTH{ 2U };
+    static constexpr std::size_t REBUILD_SLACK{ 64U };
+
+    explicit CachedQuadTreeTraversal(const Tree& tree) : tree_(tree) {
+    }
+
+    // motion bounds how far the viewer moved since the previous update,
+    // in the units of the margins predicate returns
+    template<typename Predicate>
+    void update(float motion, Predicate&& predicate) {
+        entered_.clear();
+        exited_.clear();
+        if (!valid_ || expiries_.size() > REBUILD_GROWTH * rebuilt_frontier_size_ + REBUILD_SLACK) {
+            rebuild(predicate);
+            return;
+        }
+        motion_ += static_cast<double>(motion);
+        while (!expiries_.empty() && expiries_.top().motion < motion_) {
+            const auto expiry = expiries_.top();
+            expiries_.pop();
+            place(expiry.subtree, expiry.visible, predicate);
+        }
+    }
+
+    // predicate changed in a way margins don't cover (projection, view distance),
+    // next update starts from the root and still reports deltas
+    void invalidate() {
+        valid_ = false;
+    }
+
+    // tree changed so leaf indices are stale, next update reports every visible leaf as entered
+    void clear() {
+        valid_ = false;
+        visible_.clear();
+        slots_.clear();
+    }
+
+    // current visible set in no particular order
+    std::span<const LeafIndex> visible() const {
+        return visible_;
+    }
+
+    std::span<const LeafIndex> entered() const {
+        return entered_;
+    }
+
+    std::span<const LeafIndex> exited() const {
+        return exited_;
+    }
+
+    const Leaf& leaf(LeafIndex index) const {
+        return tree_.leaves()[index];
+    }
+
+    std::size_t frontierSize() const {
+        return expiries_.size();
+    }
+
+private:
+    struct Expiry {
+        // accumulated motion at which the classification may change
+        double motion;
+        typename Tree::Subtree subtree;
+        bool visible;
+    };
+
+    struct LaterExpiry {
+        bool operator()(const Expiry& lhs, const Expiry& rhs) const {
+            return lhs.motion > rhs.motion;
+        }
+    };
+
+    template<typename Predicate>
+    void rebuild(Predicate& predicate) {
+        previous_visible_.swap(visible_);
+        previous_slots_.swap(slots_);
+        visible_.clear();
+        slots_.assign(tree_.leaves().size(), NOT_VISIBLE);
+        expiries_ = {};
+        motion_ = 0.0;
+
+        const auto root = tree_.rootSubtree(typename Tree::AcceptAll{});
+        if (root.has_value()) {
+            place(*root, false, predicate);
+        }
+        rebuilt_frontier_size_ = expiries_.size();
+        valid_ = true;
+
+        // place reported the whole set as entered
+        entered_.clear();
+        for (const auto index : visible_) {
+            if (index >= previous_slots_.size() || previous_slots_[index] == NOT_VISIBLE) {
+                entered_.push_back(index);
+            }
+        }
+        for (const auto index : previous_visible_) {
+            if (index >= slots_.size() || slots_[index] == NOT_VISIBLE) {
+                exited_.push_back(index);
+            }
+        }
+    }
+
+    // classifies subtree whose leaves were all visible or all hidden,
+    // INTERSECTING nodes above leaf level are refined into their children
+    template<typename Predicate>
+    void place(const typename Tree::Subtree& subtree, bool was_visible, Predicate& predicate) {
+        const StableContainment containment = predicate(tree_.subtreeValue(subtree));
+        if (containment.containment == Containment::INTERSECTING && subtree.level < tree_.tree_height_) {
+            tree_.forEachChild(subtree, [&](const typename Tree::Subtree& child) {
+                place(child, was_visible, predicate);
+            });
+            return;
+        }
+        const auto visible = containment.containment != Containment::OUTSIDE;
+        if (visible != was_visible) {
+            tree_.depthFirstTraversal(subtree, [&](const Leaf& leaf) {
+                if (visible) {
+                    enter(leafIndex(leaf));
+                } else {
+                    exit(leafIndex(leaf));
+                }
+            }, typename Tree::AcceptAll{});
+        }
+        const auto margin = containment.margin > 0.F ? static_cast<double>(containment.margin) : 0.0;
+        expiries_.push(Expiry{ motion_ + margin, subtree, visible });
+    }
+
+    LeafIndex leafIndex(const Leaf& leaf) const {
+        return static_cast<LeafIndex>(&leaf - tree_.leaves().data());
+    }
+
+    void enter(LeafIndex index) {
+        slots_[index] = static_cast<LeafIndex>(visible_.size());
+        visible_.push_back(index);
+        entered_.push_back(index);
+    }
+
+    // last visible leaf takes the slot of the removed one
+    void exit(LeafIndex index) {
+        const auto slot = slots_[index];
+        slots_[visible_.back()] = slot;
+        visible_[slot] = visible_.back();
+        visible_.pop_back();
+        slots_[index] = NOT_VISIBLE;
+        exited_.push_back(index);
+    }
+
+    const Tree& tree_;
+    bool valid_{ false };
+    double motion_{ 0.0 };
+    std::size_t rebuilt_frontier_size_{ 0 };
+    std::priority_queue<Expiry, std::vector<Expiry>, LaterExpiry> expiries_;
+    std::vector<LeafIndex> visible_;
+    // position of a leaf in visible_ or NOT_VISIBLE
+    std::vector<LeafIndex> slots_;
+    std::vector<LeafIndex> previous_visible_;
+    std::vector<LeafIndex> previous_slots_;
+    std::vector<LeafIndex> entered_;
+    std::vector<LeafIndex> exited_;
+};
+
+}
+
+#endif
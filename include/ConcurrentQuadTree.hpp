@@ -0,0 +1,167 @@
+#ifndef RW_CUBE_CONCURRENT_QUAD_TREE_HPP
+#define RW_CUBE_CONCURRENT_QUAD_TREE_HPP
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <PseudoQuadTree.hpp>
+
+namespace rw_cube {
+
+// PseudoQuadTree shared by one writer thread and any number of reader threads;
+// two copies of the tree are kept, readers traverse the published one without locks while
+// the writer updates the other, publish() swaps them and the writer replays the published
+// updates on the old copy once the last reader that entered it before the swap has left
+template<
+    typename T,
+    std::uint8_t Height = DYNAMIC_TREE_HEIGHT,
+    std::uint8_t Dimensions = QUAD_TREE_DIMENSIONS>
+struct ConcurrentQuadTree {
+    using Tree = PseudoQuadTree<T, Height, Dimensions>;
+    using Position = typename Tree::Position;
+
+    // tree has to allow dynamic updates (DENSE storage), reader_count slots are given out
+    // by the caller, one per thread reading at the same time
+    ConcurrentQuadTree(const Tree& tree, std::size_t reader_count) :
+        trees_{{ tree, tree }},
+        readers_(reader_count) {
+    }
+
+    // reader side, calls read_action with the published tree and returns its result,
+    // the tree stays valid until read_action returns
+    template<typename ReadAction>
+    decltype(auto) read(std::size_t reader, ReadAction&& read_action) const {
+        auto& slot = readers_[reader];
+        auto published = front_.load(std::memory_order_acquire);
+        while (true) {
+            slot.tree.store(published, std::memory_order_seq_cst);
+            // a swap the writer made before seeing the slot has to be followed
+            const auto current = front_.load(std::memory_order_seq_cst);
+            if (current == published) {
+                break;
+            }
+            published = current;
+        }
+        const ReaderExit reader_exit{ slot };
+        return read_action(std::as_const(trees_[published]));
+    }
+
+    // writer side, updates are seen by readers after the next publish
+
+    bool insert(const Position& position, T value) {
+        return apply(Update{ .kind = UpdateKind::INSERT, .position = position, .value = std::move(value) });
+    }
+
+    bool remove(const Position& position, const T& value) {
+        return apply(Update{ .kind = UpdateKind::REMOVE, .position = position, .value = value });
+    }
+
+    bool move(const Position& position, const T& value, const Position& new_position) {
+        return apply(Update{
+            .kind = UpdateKind::MOVE, .position = position, .new_position = new_position, .value = value
+        });
+    }
+
+    void publish() {
+        if (unpublished_.empty()) {
+            return;
+        }
+        front_.store(back(), std::memory_order_seq_cst);
+        unpublished_.swap(missed_);
+    }
+
+    // writer's own copy, it already has the unpublished updates
+    const Tree& writerTree() {
+        catchUp();
+        return trees_[back()];
+    }
+
+private:
+    static constexpr std::uint32_t NO_TREE{ std::numeric_limits<std::uint32_t>::max() };
+
+    enum class UpdateKind : std::uint8_t {
+        INSERT,
+        REMOVE,
+        MOVE
+    };
+
+    struct Update {
+        UpdateKind kind;
+        Position position{};
+        Position new_position{};
+        T value;
+    };
+
+    // separate cache lines so readers don't share the line they write
+    struct alignas(64) ReaderSlot {
+        // tree the reader is in or NO_TREE
+        std::atomic<std::uint32_t> tree{ NO_TREE };
+    };
+
+    struct ReaderExit {
+        ReaderSlot& slot;
+
+        explicit ReaderExit(ReaderSlot& reader_slot) : slot(reader_slot) {
+        }
+        ReaderExit(const ReaderExit&) = delete;
+        ReaderExit& operator=(const ReaderExit&) = delete;
+
+        ~ReaderExit() {
+            slot.tree.store(NO_TREE, std::memory_order_release);
+        }
+    };
+
+    std::uint32_t back() const {
+        return 1U - front_.load(std::memory_order_relaxed);
+    }
+
+    bool apply(Update update) {
+        catchUp();
+        const auto applied = applyTo(trees_[back()], update);
+        unpublished_.push_back(std::move(update));
+        return applied;
+    }
+
+    // back copy missed the updates published last time, they are replayed once no reader is in it,
+    // both copies saw the same updates in the same order so they end up equal
+    void catchUp() {
+        if (missed_.empty()) {
+            return;
+        }
+        const auto tree = back();
+        for (const auto& slot : readers_) {
+            while (slot.tree.load(std::memory_order_seq_cst) == tree) {
+                std::this_thread::yield();
+            }
+        }
+        for (const auto& update : missed_) {
+            applyTo(trees_[tree], update);
+        }
+        missed_.clear();
+    }
+
+    static bool applyTo(Tree& tree, const Update& update) {
+        switch (update.kind) {
+        case UpdateKind::INSERT: return tree.insert(update.position, update.value);
+        case UpdateKind::REMOVE: return tree.remove(update.position, update.value);
+        case UpdateKind::MOVE: return tree.move(update.position, update.value, update.new_position);
+        }
+        return false;
+    }
+
+    std::array<Tree, 2> trees_;
+    std::atomic<std::uint32_t> front_{ 0U };
+    mutable std::vector<ReaderSlot> readers_;
+    // owned by the writer
+    std::vector<Update> unpublished_;
+    std::vector<Update> missed_;
+};
+
+}
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef RW_CUBE_FRUSTUM_HPP
+#define RW_CUBE_FRUSTUM_HPP
+
+#include <array>
+#include <cinttypes>
+#include <type_traits>
+
+#include <linmath.h>
+
+#include <PseudoQuadTree.hpp>
+#include <LooseQuadTree.hpp>
+
+namespace rw_cube {
+
+struct Frustum {
+    static constexpr std::size_t PLANE_COUNT{ 6U };
+
+    // planes stored as a*x + b*y + c*z + d >= 0 (inside),
+    // one array per coefficient so 4 boxes can be tested against a plane at once
+    alignas(16) std::array<float, PLANE_COUNT> a_{};
+    alignas(16) std::array<float, PLANE_COUNT> b_{};
+    alignas(16) std::array<float, PLANE_COUNT> c_{};
+    alignas(16) std::array<float, PLANE_COUNT> d_{};
+
+    // extracts normalized planes from view projection matrix (Gribb-Hartmann)
+    explicit Frustum(const mat4x4 vp); // NOLINT
+
+    [[nodiscard]] bool intersectsBox(
+        float center_x, float center_y, float center_z,
+        float extent_x, float extent_y, float extent_z) const;
+
+    [[nodiscard]] Containment classifyBox(
+        float center_x, float center_y, float center_z,
+        float extent_x, float extent_y, float extent_z) const;
+
+    // classifyBox with the camera motion it holds for; motion is camera translation plus 
+    // rotation_reach times the distance its rotation moves a unit vector, 
+    // the margin shrinks for boxes reaching further from the camera than rotation_reach
+    [[nodiscard]] StableContainment classifyBoxStable(
+        float center_x, float center_y, float center_z,
+        float extent_x, float extent_y, float extent_z,
+        const vec3 camera_position, float rotation_reach) const; // NOLINT
+
+    // bit i of the result is set when box i intersects the frustum, boxes share y and extents
+    [[nodiscard]] std::uint32_t intersectsBoxes4(
+        const std::array<float, 4>& center_x,
+        const std::array<float, 4>& center_z,
+        float center_y,
+        float extent_x, float extent_y, float extent_z) const;
+
+    // boxes with their own y
+    [[nodiscard]] std::uint32_t intersectsBoxes4(
+        const std::array<float, 4>& center_x,
+        const std::array<float, 4>& center_y,
+        const std::array<float, 4>& center_z,
+        float extent_x, float extent_y, float extent_z) const;
+
+    [[nodiscard]] ContainmentMask classifyBoxes4(
+        const std::array<float, 4>& center_x,
+        const std::array<float, 4>& center_z,
+        float center_y,
+        float extent_x, float extent_y, float extent_z) const;
+};
+
+template<
+    typename T, 
+    std::uint8_t Height = DYNAMIC_TREE_HEIGHT, 
+    std::uint8_t Dimensions = QUAD_TREE_DIMENSIONS> 
+struct QuadTreeFrustumCulling {
+    using Tree = PseudoQuadTree<T, Height, Dimensions>;
+
+    const Frustum& frustum_;
+    // y range of an object around its leaf's y, leaves of a quad tree are at y = 0
+    float y_min_;
+    float y_max_;
+    // half size in x/z of an object placed in a leaf, node boxes are grown by it
+    float leaf_extent_;
+
+    Containment operator()(const typename Tree::TraversalValue& value) const {
+        const auto [node_y, node_depth] = nodeY(value);
+        return frustum_.classifyBox(
+            value.x, node_y + (y_min_ + y_max_)/2.F, value.z,
+            value.area_width/2.F + leaf_extent_,
+            node_depth/2.F + (y_max_ - y_min_)/2.F,
+            value.area_height/2.F + leaf_extent_
+        );
+    }
+
+    // operator() with the camera motion it holds for, see Frustum::classifyBoxStable
+    StableContainment stableContainment(
+        const typename Tree::TraversalValue& value, const vec3 camera_position, float rotation_reach) const { // NOLINT
+        const auto [node_y, node_depth] = nodeY(value);
+        return frustum_.classifyBoxStable(
+            value.x, node_y + (y_min_ + y_max_)/2.F, value.z,
+            value.area_width/2.F + leaf_extent_,
+            node_depth/2.F + (y_max_ - y_min_)/2.F,
+            value.area_height/2.F + leaf_extent_,
+            camera_position, rotation_reach
+        );
+    }
+
+    // frustum test of node combined with predicate
+    template<typename Predicate>
+    Containment classifyNode(const typename Tree::TraversalValue& value, Predicate& predicate) const {
+        const auto containment = classify(predicate, value);
+        if (containment == Containment::OUTSIDE) {
+            return containment;
+        }
+        return intersect(containment, (*this)(value));
+    }
+
+    // frustum test of 4 children (of an octree y layer) at once combined with predicate of each accepted child
+    template<typename Predicate>
+    ContainmentMask classifyChildren(
+        const Tree& tree, const typename Tree::ChildrenValue& children, Predicate& predicate) const {
+        ContainmentMask mask{};
+        if constexpr (Dimensions == QUAD_TREE_DIMENSIONS) {
+            mask = frustum_.classifyBoxes4(
+                children.coordinates.x, children.coordinates.z, (y_min_ + y_max_)/2.F,
+                children.area_width/2.F + leaf_extent_,
+                (y_max_ - y_min_)/2.F,
+                children.area_height/2.F + leaf_extent_
+            );
+        } else {
+            for (std::uint32_t layer{0}; layer<2U; ++layer) {
+                const auto layer_mask = frustum_.classifyBoxes4(
+                    children.coordinates.x, children.coordinates.z, 
+                    children.coordinates.y[layer] + (y_min_ + y_max_)/2.F,
+                    children.area_width/2.F + leaf_extent_,
+                    children.area_depth/2.F + (y_max_ - y_min_)/2.F,
+                    children.area_height/2.F + leaf_extent_
+                );
+                mask.accepted |= layer_mask.accepted << (4U * layer);
+                mask.inside |= layer_mask.inside << (4U * layer);
+            }
+        }
+        mask.accepted &= children.child_mask;
+        mask.inside &= mask.accepted;
+        if constexpr (!std::is_same_v<std::remove_cvref_t<Predicate>, typename Tree::AcceptAll>) {
+            for (std::uint32_t c{0}; c<Tree::CHILD_COUNT; ++c) {
+                if ((mask.accepted & (1U << c)) == 0U) {
+                    continue;
+                }
+                switch (classify(predicate, tree.childValue(children, c))) {
+                case Containment::OUTSIDE: mask.accepted &= ~(1U << c); [[fallthrough]];
+                case Containment::INTERSECTING: mask.inside &= ~(1U << c); break;
+                case Containment::INSIDE: break;
+                }
+            }
+        }
+        return mask;
+    }
+
+    // children of a node are tested 4 at once, leaves of accepted nodes in batches of 4
+    template<typename ValueAction, typename Predicate = typename Tree::AcceptAll>
+    void depthFirstTraversal(const Tree& tree, ValueAction&& value_action, Predicate&& predicate = {}) const {
+        const auto root = tree.rootSubtree([&](const typename Tree::TraversalValue& value) {
+            return classifyNode(value, predicate);
+        });
+        if (root.has_value()) {
+            depthFirstTraversal(tree, *root, value_action, predicate);
+        }
+    }
+
+    // subtree comes from tree.splitTraversal with classifyNode as its predicate
+    template<typename ValueAction, typename Predicate = typename Tree::AcceptAll>
+    void depthFirstTraversal(
+        const Tree& tree, const typename Tree::Subtree& subtree, 
+        ValueAction&& value_action, Predicate&& predicate = {}) const {
+        batchedTraversal(value_action, [&](const auto& leaf_action) {
+            tree.siblingDepthFirstTraversal(subtree, leaf_action, [&](const typename Tree::ChildrenValue& children) {
+                return classifyChildren(tree, children, predicate);
+            });
+        });
+    }
+
+private:
+    // center and size in y of a node, quad tree nodes are flat at y = 0
+    static std::array<float, 2> nodeY(const typename Tree::TraversalValue& value) {
+        if constexpr (Dimensions == QUAD_TREE_DIMENSIONS) {
+            return {{ 0.F, 0.F }};
+        } else {
+            return {{ value.y, value.area_depth }};
+        }
+    }
+
+    template<typename ValueAction, typename Traversal>
+    void batchedTraversal(ValueAction& value_action, Traversal&& traversal) const {
+        std::array<const typename Tree::Leaf*, 4> batch{};
+        std::array<float, 4> batch_x{};
+        std::array<float, 4> batch_y{};
+        std::array<float, 4> batch_z{};
+        std::uint32_t batch_size{ 0 };
+
+        const auto flush = [&] {
+            const auto mask = Dimensions == QUAD_TREE_DIMENSIONS ?
+                frustum_.intersectsBoxes4(
+                    batch_x, batch_z, (y_min_ + y_max_)/2.F,
+                    leaf_extent_, (y_max_ - y_min_)/2.F, leaf_extent_
+                ) :
+                frustum_.intersectsBoxes4(
+                    batch_x, batch_y, batch_z,
+                    leaf_extent_, (y_max_ - y_min_)/2.F, leaf_extent_
+                );
+            for (std::uint32_t i{0}; i<batch_size; ++i) {
+                if ((mask & (1U << i)) != 0U) {
+                    value_action(*batch[i]);
+                }
+            }
+            batch_size = 0;
+        };
+
+        traversal([&](const typename Tree::Leaf& leaf) {
+            batch[batch_size] = &leaf;
+            batch_x[batch_size] = leaf.x;
+            if constexpr (Dimensions == OCTREE_DIMENSIONS) {
+                batch_y[batch_size] = leaf.y + (y_min_ + y_max_)/2.F;
+            }
+            batch_z[batch_size] = leaf.z;
+            if (++batch_size == batch.size()) {
+                flush();
+            }
+        });
+        if (batch_size > 0) {
+            flush();
+        }
+    }
+};
+
+// predicate for LooseQuadTree traversal, grown node bounds and leaf boxes are tested as they are
+struct LooseQuadTreeFrustumCulling {
+    const Frustum& frustum_;
+
+    template<typename Value>
+    Containment operator()(const Value& value) const {
+        return frustum_.classifyBox(
+            value.x, (value.y_min + value.y_max)/2.F, value.z,
+            value.area_width/2.F, (value.y_max - value.y_min)/2.F, value.area_height/2.F
+        );
+    }
+};
+
+}
+
+#endif
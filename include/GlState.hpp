@@ -0,0 +1,35 @@
+#ifndef RW_CUBE_GL_STATE_HPP
+#define RW_CUBE_GL_STATE_HPP
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace rw_cube {
+
+// cached copy of the GL state the wrappers bind, calls matching the cache are elided;
+// the state has to be changed only through it and invalidate() called after deleting
+// objects since GL may hand their names out again
+struct GlState {
+	struct Counters {
+		std::uint32_t issued{ 0 };
+		std::uint32_t elided{ 0 };
+	};
+
+	static void useProgram(std::uint32_t program_id);
+	static void bindVertexArray(std::uint32_t vao_id);
+	static void bindTextureUnit(std::uint32_t unit, std::uint32_t texture_id);
+	// GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER bindings are cached, others always issued
+	static void bindBufferBase(std::uint32_t target, std::uint32_t binding, std::uint32_t buffer_id);
+	static void bindBufferRange(
+		std::uint32_t target, std::uint32_t binding, std::uint32_t buffer_id, std::size_t offset, std::size_t size);
+	static void viewport(std::int32_t x, std::int32_t y, std::int32_t width, std::int32_t height);
+
+	// forgets the cached state, the next call of each kind is issued
+	static void invalidate();
+	// counters since the previous call, called once per frame they count the frame's calls
+	static Counters takeCounters();
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef RW_CUBE_GPU_CULLING_HPP
+#define RW_CUBE_GPU_CULLING_HPP
+
+#include <array>
+#include <cinttypes>
+#include <span>
+
+#include <Frustum.hpp>
+#include <Model.hpp>
+#include <Shader.hpp>
+
+namespace rw_cube {
+
+// objects and mesh bounds are uploaded once, every frame a compute shader tests each object
+// against view distance and frustum and appends visible ones to the instances of its mesh,
+// counts go straight into the indirect draw commands so the CPU cost doesn't depend on object count
+struct GpuCulling {
+	// matches std430 struct Object of the culling shader
+	struct Object {
+		std::array<float, 3> position;
+		// index into the meshes given to the constructor
+		std::uint32_t mesh;
+	};
+
+	// layout read by glDrawElementsIndirect
+	struct DrawElementsIndirectCommand {
+		std::uint32_t count;
+		std::uint32_t instance_count;
+		std::uint32_t first_index;
+		std::int32_t base_vertex;
+		std::uint32_t base_instance;
+	};
+
+	// matches std140 uniform block Culling of the culling shader
+	struct CullingData {
+		std::array<std::array<float, 4>, Frustum::PLANE_COUNT> planes;
+		std::array<float, 3> camera_pos;
+		float view_distance;
+		std::uint32_t object_count;
+	};
+
+	static constexpr std::uint32_t WORK_GROUP_SIZE{ 64U };
+
+	std::uint32_t objects_ssbo_id_{ 0 };
+	std::uint32_t meshes_ssbo_id_{ 0 };
+	std::uint32_t commands_buffer_id_{ 0 };
+	// commands with no instances, copied over commands_buffer_id_ before culling
+	std::uint32_t empty_commands_buffer_id_{ 0 };
+	// InstanceOffset per visible object, mesh m owns the range starting at its base_instance
+	std::uint32_t instances_buffer_id_{ 0 };
+	std::uint32_t culling_ubo_id_{ 0 };
+	std::uint32_t object_count_{ 0 };
+	std::uint32_t mesh_count_{ 0 };
+
+	ComputeShader culling_shader_;
+
+	GpuCulling(bool is_spirv, std::span<Model* const> meshes, std::span<const Object> objects);
+
+	// runs culling on the GPU, the next draw sees its result
+	void cull(const Frustum& frustum, const std::array<float, 3>& camera_pos, float view_distance) const;
+	// meshes in the order given to the constructor, one indirect draw per mesh
+	void draw(std::span<Model* const> meshes) const;
+	void deinit();
+};
+
+}
+
+#endif
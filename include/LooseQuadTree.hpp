@@ -0,0 +1,255 @@
+#ifndef RW_CUBE_LOOSE_QUAD_TREE_HPP
+#define RW_CUBE_LOOSE_QUAD_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <PseudoQuadTree.hpp>
+
+namespace rw_cube {
+
+// axis aligned box in world space
+struct Aabb {
+    std::array<float, 3> min{};
+    std::array<float, 3> max{};
+
+    bool operator==(const Aabb&) const = default;
+};
+
+// quad tree of objects with extent; an object is stored at the deepest level whose cell,
+// grown by looseness around its center, still holds the object's box, so cells of level l
+// hold objects reaching at most (looseness - 1) * cell size / 2 out of them;
+// each level is its own PseudoQuadTree which is traversed with node bounds grown by that margin
+template<typename T> struct LooseQuadTree {
+    struct Bounded {
+        T value;
+        Aabb bounds;
+
+        bool operator==(const Bounded&) const = default;
+    };
+
+    using LevelTree = PseudoQuadTree<Bounded>;
+    // x, z is the center of value.bounds
+    using Leaf = typename LevelTree::Leaf;
+    using Storage = typename LevelTree::Storage;
+    using BucketOverflow = typename LevelTree::BucketOverflow;
+
+    struct Placement {
+        Aabb bounds;
+        T value;
+    };
+
+    // grown bounds of a node or box of a leaf, predicates see both
+    struct TraversalValue {
+        // center of the footprint
+        float x;
+        float z;
+        float area_width;
+        float area_height;
+        float y_min;
+        float y_max;
+        std::uint8_t level;
+    };
+
+    struct AcceptAll {
+        constexpr bool operator()(const TraversalValue&) const {
+            return true;
+        }
+    };
+
+    // objects stored at one level
+    struct Level {
+        LevelTree tree;
+        // how far objects reach out of their cell
+        float margin_x;
+        float margin_z;
+        // y range of the objects inserted since the last build, removals don't shrink it
+        float y_min{ std::numeric_limits<float>::max() };
+        float y_max{ std::numeric_limits<float>::lowest() };
+    };
+
+    // levels_[l] holds the objects of tree level l + 1
+    std::vector<Level> levels_;
+    // objects too large for level 1 or centered outside of the area, tested one by one
+    std::vector<Leaf> root_leaves_;
+    float looseness_;
+
+    LooseQuadTree(
+        std::uint8_t tree_height,
+        float area_width,
+        float area_height,
+        float area_world_x_pos,
+        float area_world_z_pos,
+        float looseness = 2.F,
+        Storage storage = Storage::DENSE,
+        std::uint32_t bucket_capacity = 8U,
+        BucketOverflow bucket_overflow = BucketOverflow::DROP) :
+        looseness_(looseness) {
+        if (!(looseness >= 1.F)) {
+            throw std::invalid_argument("loose quad tree looseness has to be at least 1");
+        }
+        levels_.reserve(tree_height + 1U);
+        for (std::uint8_t level{0}; level<=tree_height; ++level) {
+            const auto cell_count = static_cast<float>(2U << level);
+            levels_.push_back(Level{
+                .tree = LevelTree(
+                    level, area_width, area_height, area_world_x_pos, area_world_z_pos,
+                    storage, bucket_capacity, bucket_overflow
+                ),
+                .margin_x = (looseness - 1.F) * area_width / cell_count / 2.F,
+                .margin_z = (looseness - 1.F) * area_height / cell_count / 2.F
+            });
+        }
+    }
+
+    // replaces tree content, placements over bucket capacity of a cell are handled
+    // by bucket_overflow; returns number of stored placements
+    std::size_t build(std::span<const Placement> placements) {
+        std::vector<std::vector<typename LevelTree::Placement>> level_placements(levels_.size());
+        root_leaves_.clear();
+        for (auto& level : levels_) {
+            level.y_min = std::numeric_limits<float>::max();
+            level.y_max = std::numeric_limits<float>::lowest();
+        }
+        for (const auto& placement : placements) {
+            const auto [x, z] = center(placement.bounds);
+            auto bounded = Bounded{ .value = placement.value, .bounds = placement.bounds };
+            const auto level = levelOf(placement.bounds);
+            if (!level.has_value()) {
+                root_leaves_.push_back(Leaf{ .value = std::move(bounded), .x = x, .z = z });
+                continue;
+            }
+            growYRange(levels_[*level], placement.bounds);
+            level_placements[*level].push_back(
+                typename LevelTree::Placement{ .x = x, .z = z, .value = std::move(bounded) }
+            );
+        }
+        auto count = root_leaves_.size();
+        for (std::size_t i{0}; i<levels_.size(); ++i) {
+            count += levels_[i].tree.build(level_placements[i]);
+        }
+        return count;
+    }
+
+    // like PseudoQuadTree::insert, needs DENSE storage unless the object goes to the root
+    bool insert(const Aabb& bounds, T value) {
+        const auto [x, z] = center(bounds);
+        auto bounded = Bounded{ .value = std::move(value), .bounds = bounds };
+        const auto level = levelOf(bounds);
+        if (!level.has_value()) {
+            root_leaves_.push_back(Leaf{ .value = std::move(bounded), .x = x, .z = z });
+            return true;
+        }
+        if (!levels_[*level].tree.insert(x, z, std::move(bounded))) {
+            return false;
+        }
+        growYRange(levels_[*level], bounds);
+        return true;
+    }
+
+    bool remove(const Aabb& bounds, const T& value) {
+        const auto [x, z] = center(bounds);
+        const auto bounded = Bounded{ .value = value, .bounds = bounds };
+        const auto level = levelOf(bounds);
+        if (level.has_value()) {
+            return levels_[*level].tree.remove(x, z, bounded);
+        }
+        const auto leaf = std::find_if(root_leaves_.begin(), root_leaves_.end(), [&](const Leaf& root_leaf) {
+            return root_leaf.value == bounded;
+        });
+        if (leaf == root_leaves_.end()) {
+            return false;
+        }
+        *leaf = std::move(root_leaves_.back());
+        root_leaves_.pop_back();
+        return true;
+    }
+
+    // predicate returns either bool or Containment, it is called with the grown bounds
+    // of nodes and with the box of every leaf of an accepted node, only leaves whose
+    // box it accepts are passed to value_action
+    template<typename ValueAction, typename Predicate = AcceptAll>
+    void depthFirstTraversal(ValueAction&& value_action, Predicate&& predicate = {}) const {
+        for (const auto& leaf : root_leaves_) {
+            if (classify(predicate, leafValue(leaf, 0U)) != Containment::OUTSIDE) {
+                value_action(leaf);
+            }
+        }
+        for (std::size_t i{0}; i<levels_.size(); ++i) {
+            const auto& level = levels_[i];
+            const auto leaf_level = static_cast<std::uint8_t>(i + 1U);
+            level.tree.depthFirstTraversal(
+                [&](const Leaf& leaf) {
+                    if (classify(predicate, leafValue(leaf, leaf_level)) != Containment::OUTSIDE) {
+                        value_action(leaf);
+                    }
+                },
+                [&](const typename LevelTree::TraversalValue& value) {
+                    return classify(predicate, nodeValue(level, value));
+                }
+            );
+        }
+    }
+
+    // deepest level (index into levels_) whose grown cells hold bounds,
+    // nullopt when it belongs to the root
+    std::optional<std::size_t> levelOf(const Aabb& bounds) const {
+        const auto half_width = (bounds.max[0] - bounds.min[0])/2.F;
+        const auto half_height = (bounds.max[2] - bounds.min[2])/2.F;
+        const auto [x, z] = center(bounds);
+        for (auto i{levels_.size()}; i-- > 0U;) {
+            if (half_width <= levels_[i].margin_x && half_height <= levels_[i].margin_z) {
+                if (!levels_[i].tree.cellQuadKey(x, z).has_value()) {
+                    return std::nullopt;
+                }
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static TraversalValue leafValue(const Leaf& leaf, std::uint8_t level) {
+        const auto& bounds = leaf.value.bounds;
+        return TraversalValue{
+            .x = leaf.x,
+            .z = leaf.z,
+            .area_width = bounds.max[0] - bounds.min[0],
+            .area_height = bounds.max[2] - bounds.min[2],
+            .y_min = bounds.min[1],
+            .y_max = bounds.max[1],
+            .level = level
+        };
+    }
+
+    static TraversalValue nodeValue(const Level& level, const typename LevelTree::TraversalValue& value) {
+        return TraversalValue{
+            .x = value.x,
+            .z = value.z,
+            .area_width = value.area_width + 2.F * level.margin_x,
+            .area_height = value.area_height + 2.F * level.margin_z,
+            .y_min = level.y_min,
+            .y_max = level.y_max,
+            .level = value.level
+        };
+    }
+
+private:
+    static std::array<float, 2> center(const Aabb& bounds) {
+        return {{ (bounds.min[0] + bounds.max[0])/2.F, (bounds.min[2] + bounds.max[2])/2.F }};
+    }
+
+    static void growYRange(Level& level, const Aabb& bounds) {
+        level.y_min = std::min(level.y_min, bounds.min[1]);
+        level.y_max = std::max(level.y_max, bounds.max[1]);
+    }
+};
+
+}
+
+#endif
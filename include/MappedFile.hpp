@@ -0,0 +1,35 @@
+#ifndef RW_CUBE_MAPPED_FILE_HPP
+#define RW_CUBE_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace rw_cube {
+
+// read only memory mapping of a whole file, pages are loaded on first access
+struct MappedFile {
+	explicit MappedFile(const std::filesystem::path& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+	~MappedFile();
+
+	[[nodiscard]] std::span<const std::byte> bytes() const;
+
+	// reads one byte of every page so later accesses don't wait for the disk
+	void prefault() const;
+
+private:
+	const std::byte* data_{ nullptr };
+	std::size_t size_{ 0 };
+#ifdef _WIN32
+	void* file_handle_{ nullptr };
+	void* mapping_handle_{ nullptr };
+#endif
+};
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <array>
 #include <filesystem>
+#include <span>
 
 #include <Shader.hpp>
 
@@ -17,20 +18,51 @@ struct Model {
 		alignas(16) float specular[3]{0.F, 0.F, 0.F};
 	};
 
+	using InstanceOffset = std::array<float, 3>;
+
+	static constexpr std::uint32_t VERTEX_BINDING{ 0U };
+	static constexpr std::uint32_t INSTANCE_BINDING{ 1U };
+
 	std::uint32_t vbo_id_{ 0 };
 	std::uint32_t vao_id_{ 0 };
+	// same vertices with the per instance offsets sourced from the instance buffer,
+	// draws through vao_id_ read the offset set by ObjectBuffer::select
+	std::uint32_t instanced_vao_id_{ 0 };
     std::uint32_t ebo_id_{ 0 };
 	std::uint32_t tex_id_{ 0 };
+	std::uint32_t instance_vbo_id_{ 0 };
+	std::uint32_t instance_capacity_{ 0 };
 
 	Material model_material_{};
+	// ObjectBuffer object with the model's material that instanced draws read,
+	// its transform is applied before the instance offsets
+	std::uint32_t object_id_{ 0 };
 
 	std::uint32_t indices_count_{ 0 };
+
+	// object space bounds of the vertex positions
+	std::array<float, 3> bounds_min_{};
+	std::array<float, 3> bounds_max_{};
 	
 	Shader model_shader_;
+	Shader model_instanced_shader_;
 
     Model(bool is_spirv, const std::filesystem::path& obj_path, const std::filesystem::path& tex_path);
 	void draw() const;
+	// selects object_id_, draws place the model with ObjectBuffer::select
 	void bind() const;
+
+	// per instance world offsets read at SHCONFIG_IN_OFFSET_LOCATION, 
+	// instance buffer grows when offsets don't fit
+	void sendInstanceData(std::span<const InstanceOffset> offsets);
+	// overwrites instances from first on, instances before first survive growth
+	void sendInstanceData(std::span<const InstanceOffset> offsets, std::uint32_t first);
+	// grows the instance buffer to hold count instances keeping the first kept_count
+	void reserveInstances(std::uint32_t count, std::uint32_t kept_count);
+	void drawInstanced(std::uint32_t instance_count) const;
+	void bindInstanced() const;
+	// instances read from another buffer laid out as InstanceOffset
+	void bindInstanced(std::uint32_t instance_buffer_id) const;
 	void deinit();
 };
 
@@ -0,0 +1,64 @@
+#ifndef RW_CUBE_OBJECT_BUFFER_HPP
+#define RW_CUBE_OBJECT_BUFFER_HPP
+
+#include <array>
+#include <cinttypes>
+#include <vector>
+
+#include <linmath.h>
+
+#include <Model.hpp>
+
+namespace rw_cube {
+
+// per object data kept on the GPU between frames, transforms with a material index in one
+// shader storage buffer and the material table in another; draws pick their object with select(),
+// upload() sends only the objects and materials changed since the previous upload
+struct ObjectBuffer {
+	// matches std430 struct Object of the shaders
+	struct Object {
+		mat4x4 model;
+		// index into the material table
+		std::uint32_t material;
+		// std430 rounds the struct up to the alignment of mat4
+		std::array<std::uint32_t, 3> padding_;
+	};
+
+	// objects / materials changed since the previous upload, empty when first == last
+	struct DirtyRange {
+		std::uint32_t first{ 0 };
+		std::uint32_t last{ 0 };
+
+		void add(std::uint32_t index);
+	};
+
+	std::uint32_t objects_id_{ 0 };
+	std::uint32_t materials_id_{ 0 };
+	std::uint32_t object_capacity_;
+	std::uint32_t material_capacity_;
+	std::vector<Object> objects_;
+	std::vector<Model::Material> materials_;
+	DirtyRange dirty_objects_;
+	DirtyRange dirty_materials_;
+
+	// buffers are bound at SHCONFIG_OBJECTS_BINDING and SHCONFIG_MATERIALS_BINDING,
+	// adding past the capacities throws
+	ObjectBuffer(std::uint32_t object_capacity, std::uint32_t material_capacity);
+
+	std::uint32_t addMaterial(const Model::Material& material);
+	std::uint32_t addObject(const mat4x4 model, std::uint32_t material); // NOLINT
+	// object is uploaded again only when its transform changed
+	void setObject(std::uint32_t object, const mat4x4 model); // NOLINT
+	void upload();
+
+	// object read by the following draws and offset added to its world positions, both are
+	// constant vertex attributes read at SHCONFIG_IN_OBJECT_LOCATION / SHCONFIG_IN_OFFSET_LOCATION
+	// while the bound vertex array doesn't source them from a buffer
+	static void select(std::uint32_t object, const Model::InstanceOffset& offset = {});
+
+	void deinit();
+};
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef RW_CUBE_PAGED_QUAD_TREE_HPP
+#define RW_CUBE_PAGED_QUAD_TREE_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <PseudoQuadTree.hpp>
+
+namespace rw_cube {
+
+// area split into 4^page_level cells, each cell is a PseudoQuadTree snapshot in its own file (page);
+// update() asks a background thread to map pages within load distance of the camera and drops
+// the ones past load distance + evict margin, traversal only visits pages which already arrived;
+// only pages near the camera are tracked so the cost of update doesn't grow with page_level
+struct PagedQuadTree {
+	using Page = PseudoQuadTree<AssetId>;
+
+	PagedQuadTree(
+		std::filesystem::path directory,
+		std::uint8_t page_level,
+		float area_width,
+		float area_height,
+		float area_world_x_pos,
+		float area_world_z_pos,
+		float evict_margin,
+		AssetId asset_count);
+	PagedQuadTree(const PagedQuadTree&) = delete;
+	PagedQuadTree(PagedQuadTree&&) = delete;
+	PagedQuadTree& operator=(const PagedQuadTree&) = delete;
+	PagedQuadTree& operator=(PagedQuadTree&&) = delete;
+	~PagedQuadTree();
+
+	// splits placements into pages of page_height and writes every non empty one into directory
+	static void writePages(
+		const std::filesystem::path& directory,
+		std::uint8_t page_level,
+		std::uint8_t page_height,
+		float area_width,
+		float area_height,
+		float area_world_x_pos,
+		float area_world_z_pos,
+		std::span<const Page::Placement> placements,
+		Page::Storage storage = Page::Storage::SPARSE,
+		std::uint32_t bucket_capacity = 1U);
+
+	// called once per frame from the traversing thread, never waits for the loader
+	void update(float camera_x, float camera_z, float load_distance);
+
+	[[nodiscard]] std::size_t residentPageCount() const;
+
+	// resident pages in quad key order
+	template<typename PageAction>
+	void forEachResidentPage(PageAction&& page_action) const {
+		for (const auto& [quad_key, page] : pages_) {
+			if (page.tree != nullptr) {
+				page_action(*page.tree);
+			}
+		}
+	}
+
+	template<typename ValueAction, typename Predicate = Page::AcceptAll>
+	void depthFirstTraversal(ValueAction&& value_action, Predicate&& predicate = {}) const {
+		forEachResidentPage([&](const Page& page) {
+			page.depthFirstTraversal(value_action, predicate);
+		});
+	}
+
+	void deinit();
+
+private:
+	// pages which aren't tracked are absent
+	enum class PageState : std::uint8_t {
+		REQUESTED,
+		RESIDENT,
+		// no file, area of the page is empty
+		EMPTY
+	};
+
+	struct PageSlot {
+		PageState state{ PageState::REQUESTED };
+		std::shared_ptr<const Page> tree;
+	};
+
+	struct LoadedPage {
+		std::uint32_t quad_key;
+		std::shared_ptr<const Page> tree;
+	};
+
+	static std::filesystem::path pagePath(const std::filesystem::path& directory, std::uint8_t page_level, std::uint32_t quad_key);
+	void work();
+
+	std::filesystem::path directory_;
+	std::uint8_t page_level_;
+	float area_width_;
+	float area_height_;
+	float area_world_x_pos_;
+	float area_world_z_pos_;
+	float evict_margin_;
+	// pages holding other asset ids are treated as unreadable
+	AssetId asset_count_;
+
+	// owned by the traversing thread, keyed by quad key
+	std::map<std::uint32_t, PageSlot> pages_;
+
+	std::mutex mutex_;
+	std::condition_variable requests_cv_;
+	std::deque<std::uint32_t> requests_;
+	std::vector<LoadedPage> loaded_;
+	bool stop_{ false };
+	std::thread loader_;
+};
+
+}
+
+#endif
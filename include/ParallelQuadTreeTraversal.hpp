@@ -0,0 +1,86 @@
+#ifndef RW_CUBE_PARALLEL_QUAD_TREE_TRAVERSAL_HPP
+#define RW_CUBE_PARALLEL_QUAD_TREE_TRAVERSAL_HPP
+
+#include <span>
+#include <vector>
+
+#include <PseudoQuadTree.hpp>
+#include <ThreadPool.hpp>
+
+namespace rw_cube {
+
+// splits the traversal into subtrees at split level, subtrees are traversed on the thread pool,
+// each thread appends accepted leaves to its own buffer and the buffers are merged in subtree order, 
+// so the result is the same as of the single threaded traversal
+template<
+    typename T, 
+    std::uint8_t Height = DYNAMIC_TREE_HEIGHT, 
+    std::uint8_t Dimensions = QUAD_TREE_DIMENSIONS> 
+struct ParallelQuadTreeTraversal {
+    using Tree = PseudoQuadTree<T, Height, Dimensions>;
+    using Leaf = typename Tree::Leaf;
+
+    ParallelQuadTreeTraversal(ThreadPool& thread_pool, std::uint8_t split_level) :
+        thread_pool_(thread_pool), 
+        split_level_(split_level),
+        thread_leaves_(thread_pool.threadCount()) {
+    }
+
+    template<typename Predicate>
+    std::span<const Leaf* const> traverse(const Tree& tree, Predicate&& predicate) {
+        return traverse(tree, predicate, [&](const typename Tree::Subtree& subtree, const auto& leaf_action) {
+            tree.depthFirstTraversal(subtree, leaf_action, predicate);
+        });
+    }
+
+    // subtree_traversal(subtree, leaf_action) is called concurrently and has to pass accepted 
+    // leaves of the subtree to leaf_action, predicate splits the tree so it has to accept 
+    // nodes above split level the same way subtree_traversal does
+    template<typename Predicate, typename SubtreeTraversal>
+    std::span<const Leaf* const> traverse(const Tree& tree, Predicate&& predicate, SubtreeTraversal&& subtree_traversal) {
+        tree.splitTraversal(split_level_, predicate, subtrees_);
+        subtree_outputs_.resize(subtrees_.size());
+        for (auto& buffer : thread_leaves_) {
+            buffer.leaves.clear();
+        }
+
+        thread_pool_.run(subtrees_.size(), [&](std::size_t subtree_index, std::size_t thread_index) {
+            auto& buffer = thread_leaves_[thread_index].leaves;
+            const auto first = buffer.size();
+            subtree_traversal(subtrees_[subtree_index], [&buffer](const Leaf& leaf) {
+                buffer.push_back(&leaf);
+            });
+            subtree_outputs_[subtree_index] = SubtreeOutput{ thread_index, first, buffer.size() - first };
+        });
+
+        leaves_.clear();
+        for (const auto& output : subtree_outputs_) {
+            const auto first = std::next(thread_leaves_[output.thread].leaves.begin(), static_cast<std::ptrdiff_t>(output.first));
+            leaves_.insert(leaves_.end(), first, std::next(first, static_cast<std::ptrdiff_t>(output.count)));
+        }
+        return leaves_;
+    }
+
+private:
+    struct SubtreeOutput {
+        std::size_t thread;
+        std::size_t first;
+        std::size_t count;
+    };
+
+    // separate cache lines so threads don't share vector bookkeeping
+    struct alignas(64) ThreadLeaves {
+        std::vector<const Leaf*> leaves;
+    };
+
+    ThreadPool& thread_pool_;
+    std::uint8_t split_level_;
+    std::vector<typename Tree::Subtree> subtrees_;
+    std::vector<SubtreeOutput> subtree_outputs_;
+    std::vector<ThreadLeaves> thread_leaves_;
+    std::vector<const Leaf*> leaves_;
+};
+
+}
+
+#endif
@@ -1,177 +1,1082 @@
 #ifndef RW_CUBE_QUAD_TREE
 #define RW_CUBE_QUAD_TREE
 
+#include <array>
+#include <bit>
 #include <cinttypes>
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <queue>
+#include <span>
 #include <iterator>
 #include <functional>
 #include <random>
 #include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <string>
+
+#include <MappedFile.hpp>
 
 namespace rw_cube {
 
-template<typename T> struct PseudoQuadTree {
-    struct Node {
-        static constexpr auto INVALID_NEXT{ 0U };
+enum class Containment : std::uint8_t {
+    OUTSIDE,
+    INTERSECTING,
+    INSIDE
+};
+
+// region which is inside both regions
+inline Containment intersect(Containment lhs, Containment rhs) {
+    return std::min(lhs, rhs);
+}
+
+// bool predicates only tell whether region should be descended into
+template<typename Predicate, typename Value>
+Containment classify(Predicate& predicate, const Value& value) {
+    if constexpr (std::is_same_v<std::invoke_result_t<Predicate&, const Value&>, Containment>) {
+        return predicate(value);
+    } else {
+        return predicate(value) ? Containment::INTERSECTING : Containment::OUTSIDE;
+    }
+}
+
+// area of a node against the view distance around a camera, shared by the culling
+// predicate and by paged loading
+inline Containment classifyViewDistance(
+    float camera_x, float camera_z, float view_distance,
+    float x, float z, float area_width, float area_height) {
+    const auto half_area_width = area_width/2.F;
+    const auto half_area_height = area_height/2.F;
+
+    const auto area_x0 = x - half_area_width;
+    const auto area_z0 = z - half_area_height;
+
+    const auto area_x1 = x + half_area_width;
+    const auto area_z1 = z + half_area_height;
+
+    // whole area is within view distance so its subtree needs no more tests
+    const float far_dx = std::max(
+        std::abs(camera_x - area_x0), 
+        std::abs(camera_x - area_x1)
+    );
+    const float far_dz = std::max(
+        std::abs(camera_z - area_z0), 
+        std::abs(camera_z - area_z1)
+    );
+    if (std::max(far_dx, far_dz) < view_distance) {
+        return Containment::INSIDE;
+    }
+
+    if (camera_x >= area_x0 && camera_x < area_x1 &&
+        camera_z >= area_z0 && camera_z < area_z1) {
+        return Containment::INTERSECTING;
+    }
+
+    // distance along an axis is 0 when camera is within the area's range on it
+    const float dx = camera_x >= area_x0 && camera_x < area_x1 ? 0.F : std::min(
+        std::abs(camera_x - area_x0), 
+        std::abs(camera_x - area_x1)
+    );
+    const float dz = camera_z >= area_z0 && camera_z < area_z1 ? 0.F : std::min(
+        std::abs(camera_z - area_z0), 
+        std::abs(camera_z - area_z1)
+    );
+
+    return std::max(dx, dz) < view_distance ? 
+        Containment::INTERSECTING : Containment::OUTSIDE;
+}
+
+// containment which holds until the viewer has moved by margin
+struct StableContainment {
+    Containment containment;
+    float margin;
+};
+
+// holds while both hold, a rejection only needs the rejecting region to hold
+inline StableContainment intersect(StableContainment lhs, StableContainment rhs) {
+    if (lhs.containment == Containment::OUTSIDE && rhs.containment == Containment::OUTSIDE) {
+        return StableContainment{ Containment::OUTSIDE, std::max(lhs.margin, rhs.margin) };
+    }
+    if (lhs.containment == Containment::OUTSIDE || rhs.containment == Containment::OUTSIDE) {
+        return lhs.containment == Containment::OUTSIDE ? lhs : rhs;
+    }
+    return StableContainment{ intersect(lhs.containment, rhs.containment), std::min(lhs.margin, rhs.margin) };
+}
+
+// classifyViewDistance with the distance the camera can move in any direction before the result
+// may change, both distances it compares change by at most the camera movement
+inline StableContainment classifyViewDistanceStable(
+    float camera_x, float camera_z, float view_distance,
+    float x, float z, float area_width, float area_height) {
+    const auto containment = classifyViewDistance(
+        camera_x, camera_z, view_distance, x, z, area_width, area_height
+    );
+    const auto area_x0 = x - area_width/2.F;
+    const auto area_z0 = z - area_height/2.F;
+    const auto area_x1 = x + area_width/2.F;
+    const auto area_z1 = z + area_height/2.F;
+
+    const auto inside_x = camera_x >= area_x0 && camera_x < area_x1;
+    const auto inside_z = camera_z >= area_z0 && camera_z < area_z1;
+    const auto far_distance = std::max(
+        std::max(std::abs(camera_x - area_x0), std::abs(camera_x - area_x1)),
+        std::max(std::abs(camera_z - area_z0), std::abs(camera_z - area_z1))
+    );
+    const auto near_distance = std::max(
+        inside_x ? 0.F : std::min(std::abs(camera_x - area_x0), std::abs(camera_x - area_x1)),
+        inside_z ? 0.F : std::min(std::abs(camera_z - area_z0), std::abs(camera_z - area_z1))
+    );
+    auto margin = std::min(std::abs(far_distance - view_distance), std::abs(near_distance - view_distance));
+    if (inside_x && inside_z) {
+        margin = std::min({ margin, camera_x - area_x0, area_x1 - camera_x, camera_z - area_z0, area_z1 - camera_z });
+    }
+    return StableContainment{ containment, margin };
+}
+
+// stable identifier of an asset, snapshots store leaf values as asset ids
+using AssetId = std::uint32_t;
+
+// header of a binary snapshot, sections follow at the given offsets in the same byte order,
+// ENDIAN_TAG read back differently means the file was written on a machine of other endianness
+struct QuadTreeSnapshotHeader {
+    static constexpr std::array<char, 4> MAGIC{{ 'R', 'W', 'Q', 'T' }};
+    static constexpr std::uint32_t VERSION{ 1U };
+    static constexpr std::uint32_t ENDIAN_TAG{ 0x01020304U };
+
+    std::array<char, 4> magic{ MAGIC };
+    std::uint32_t endian_tag{ ENDIAN_TAG };
+    std::uint32_t version{ VERSION };
+    std::uint8_t tree_height{ 0 };
+    std::uint8_t storage{ 0 };
+    std::uint8_t node_size{ 0 };
+    std::uint8_t leaf_size{ 0 };
+    float area_width{ 0.F };
+    float area_height{ 0.F };
+    float area_world_x_pos{ 0.F };
+    float area_world_z_pos{ 0.F };
+    std::uint32_t bucket_capacity{ 0 };
+    std::uint32_t bucket_overflow{ 0 };
+    std::uint64_t leaf_count{ 0 };
+    std::uint64_t node_count{ 0 };
+    std::uint64_t nodes_offset{ 0 };
+    std::uint64_t bucket_count{ 0 };
+    std::uint64_t buckets_offset{ 0 };
+    std::uint64_t leaves_offset{ 0 };
+}; // 88 bytes
+
+// bit c describes child c of a node
+struct ContainmentMask {
+    // children which are at least partially inside
+    std::uint32_t accepted{ 0 };
+    std::uint32_t inside{ 0 };
+};
+
+// outputs of visible leaves (positions, leaf indices) grouped by a small key such as an asset id;
+// reset, append in traversal order, then finish makes every group contiguous keeping that order,
+// storage is kept between frames
+template<typename Output> struct GroupedLeafBuffer {
+    void reset(std::size_t group_count) {
+        group_offsets_.assign(group_count + 1U, 0U);
+        pending_groups_.clear();
+        pending_outputs_.clear();
+        outputs_.clear();
+        sorted_ = true;
+    }
+
+    void append(std::size_t group, Output output) {
+        ++group_offsets_[group + 1U];
+        pending_groups_.push_back(static_cast<std::uint32_t>(group));
+        pending_outputs_.push_back(std::move(output));
+        sorted_ = false;
+    }
+
+    // counting sort of appended outputs by group, does nothing when called again
+    void finish() {
+        if (sorted_) {
+            return;
+        }
+        for (std::size_t g{1}; g<group_offsets_.size(); ++g) {
+            group_offsets_[g] += group_offsets_[g - 1U];
+        }
+        outputs_.resize(pending_outputs_.size());
+        cursors_.assign(group_offsets_.begin(), std::prev(group_offsets_.end()));
+        for (std::size_t i{0}; i<pending_outputs_.size(); ++i) {
+            outputs_[cursors_[pending_groups_[i]]++] = std::move(pending_outputs_[i]);
+        }
+        sorted_ = true;
+    }
+
+    std::size_t groupCount() const {
+        return group_offsets_.size() - 1U;
+    }
+
+    // all groups one after another, e.g. one upload of an instance buffer
+    std::span<const Output> outputs() const {
+        return outputs_;
+    }
+
+    // index of the first output of group in outputs()
+    std::size_t groupOffset(std::size_t group) const {
+        return group_offsets_[group];
+    }
+
+    std::span<const Output> group(std::size_t group) const {
+        return std::span<const Output>(outputs_).subspan(
+            group_offsets_[group], group_offsets_[group + 1U] - group_offsets_[group]
+        );
+    }
+
+private:
+    // counts per group shifted by one until finish turns them into offsets
+    std::vector<std::size_t> group_offsets_{ 0U };
+    std::vector<std::size_t> cursors_;
+    std::vector<std::uint32_t> pending_groups_;
+    std::vector<Output> pending_outputs_;
+    std::vector<Output> outputs_;
+    bool sorted_{ true };
+};
+
+// tree height is given to the constructor
+inline constexpr std::uint8_t DYNAMIC_TREE_HEIGHT{ 0xFFU };
+
+// leaf level of the tree, compile time constant when the height is a template argument
+template<std::uint8_t Height> struct QuadTreeHeight {
+    static constexpr std::uint8_t tree_height_{ Height + 1U };
+};
+
+template<> struct QuadTreeHeight<DYNAMIC_TREE_HEIGHT> {
+    std::uint8_t tree_height_;
+};
+
+// number of axes a tree splits, a quad tree splits x and z, an octree also y
+inline constexpr std::uint8_t QUAD_TREE_DIMENSIONS{ 2U };
+inline constexpr std::uint8_t OCTREE_DIMENSIONS{ 3U };
+
+// center and size of a node follow from its level and key,
+// traversal derives them from the parent's instead of storing them
+template<std::uint8_t Dimensions> struct QuadTreeNode {
+    static constexpr std::uint32_t CHILD_COUNT{ 1U << Dimensions };
+    static constexpr auto INVALID_NEXT{ 0U };
 
+    std::uint32_t next : 32U - CHILD_COUNT{ INVALID_NEXT };
+    // bit c is set when child c exists
+    std::uint32_t child_mask : CHILD_COUNT{ 0U };
+}; // 4 bytes
+
+// types which name the axes of a tree; positions are arrays in key bit order x, z[, y],
+// child c lies in the upper half of axis a when bit a of c is set
+template<typename T, std::uint8_t Dimensions> struct QuadTreeAxes;
+
+template<typename T> struct QuadTreeAxes<T, QUAD_TREE_DIMENSIONS> {
+    using Node = QuadTreeNode<QUAD_TREE_DIMENSIONS>;
+    using Position = std::array<float, QUAD_TREE_DIMENSIONS>;
+
+    struct Leaf {
+        T value;
+        float x{ 0.F };
+        float z{ 0.F };
+    };
+
+    struct Placement {
         float x{ 0.F };
         float z{ 0.F };
+        T value;
+    };
+
+    struct TraversalValue {
+        Node node;
+        // center of the node's area
+        float x;
+        float z;
+        float area_width;
+        float area_height;
+        std::uint8_t level;
+    };
+
+    // centers of the 4 children of a node, one array per coordinate so they can be tested at once
+    struct alignas(16) SiblingCoordinates {
+        std::array<float, 4> x{};
+        std::array<float, 4> z{};
+    };
+
+    // children of a node as seen by sibling traversal predicate, area and level are the children's
+    struct ChildrenValue {
+        const Node& parent;
+        SiblingCoordinates coordinates;
+        std::uint32_t child_mask;
+        float area_width;
+        float area_height;
+        std::uint8_t level;
+    };
+
+    static Position position(const Leaf& leaf) {
+        return {{ leaf.x, leaf.z }};
+    }
+
+    static Position position(const Placement& placement) {
+        return {{ placement.x, placement.z }};
+    }
+
+    static Position center(const TraversalValue& value) {
+        return {{ value.x, value.z }};
+    }
+
+    static Position size(const TraversalValue& value) {
+        return {{ value.area_width, value.area_height }};
+    }
+
+    static Leaf makeLeaf(T value, const Position& position) {
+        return Leaf{ .value = std::move(value), .x = position[0], .z = position[1] };
+    }
+
+    static Placement makePlacement(T value, const Position& position) {
+        return Placement{ .x = position[0], .z = position[1], .value = std::move(value) };
+    }
+
+    static TraversalValue traversalValue(
+        const Node& node, const Position& center, const Position& size, std::uint8_t level) {
+        return TraversalValue{ 
+            .node = node, 
+            .x = center[0],
+            .z = center[1],
+            .area_width = size[0], 
+            .area_height = size[1], 
+            .level = level 
+        };
+    }
 
-        std::uint32_t next : 28{ INVALID_NEXT };
-        bool has_child_00 : 1{ false };
-        bool has_child_01 : 1{ false };
-        bool has_child_10 : 1{ false };
-        bool has_child_11 : 1{ false };
-    }; // 12 bytes
+    // center and size are the parent's
+    static ChildrenValue childrenValue(
+        const Node& parent, const Position& center, const Position& size, std::uint8_t level) {
+        const auto offset_x = size[0]/4.F;
+        const auto offset_z = size[1]/4.F;
+        return ChildrenValue{
+            .parent = parent,
+            .coordinates = SiblingCoordinates{
+                .x = {{ center[0] - offset_x, center[0] + offset_x, center[0] - offset_x, center[0] + offset_x }},
+                .z = {{ center[1] - offset_z, center[1] - offset_z, center[1] + offset_z, center[1] + offset_z }}
+            },
+            .child_mask = parent.child_mask,
+            .area_width = size[0]/2.F,
+            .area_height = size[1]/2.F,
+            .level = static_cast<std::uint8_t>(level + 1)
+        };
+    }
+
+    static TraversalValue childValue(const Node& node, const ChildrenValue& children, std::uint32_t child) {
+        return TraversalValue{
+            .node = node,
+            .x = children.coordinates.x[child],
+            .z = children.coordinates.z[child],
+            .area_width = children.area_width,
+            .area_height = children.area_height,
+            .level = children.level
+        };
+    }
+};
+
+template<typename T> struct QuadTreeAxes<T, OCTREE_DIMENSIONS> {
+    using Node = QuadTreeNode<OCTREE_DIMENSIONS>;
+    using Position = std::array<float, OCTREE_DIMENSIONS>;
 
     struct Leaf {
         T value;
         float x{ 0.F };
+        float y{ 0.F };
+        float z{ 0.F };
+    };
+
+    struct Placement {
+        float x{ 0.F };
+        float y{ 0.F };
         float z{ 0.F };
+        T value;
+    };
+
+    struct TraversalValue {
+        Node node;
+        // center of the node's volume
+        float x;
+        float y;
+        float z;
+        float area_width;
+        float area_height;
+        // size along y
+        float area_depth;
+        std::uint8_t level;
+    };
+
+    // centers of the 8 children of a node; x and z of the 4 children of a y layer 
+    // and y of both layers, so each layer can be tested at once
+    struct alignas(16) SiblingCoordinates {
+        std::array<float, 4> x{};
+        std::array<float, 4> z{};
+        std::array<float, 2> y{};
+    };
+
+    struct ChildrenValue {
+        const Node& parent;
+        SiblingCoordinates coordinates;
+        std::uint32_t child_mask;
+        float area_width;
+        float area_height;
+        float area_depth;
+        std::uint8_t level;
+    };
+
+    static Position position(const Leaf& leaf) {
+        return {{ leaf.x, leaf.z, leaf.y }};
+    }
+
+    static Position position(const Placement& placement) {
+        return {{ placement.x, placement.z, placement.y }};
+    }
+
+    static Position center(const TraversalValue& value) {
+        return {{ value.x, value.z, value.y }};
+    }
+
+    static Position size(const TraversalValue& value) {
+        return {{ value.area_width, value.area_height, value.area_depth }};
+    }
+
+    static Leaf makeLeaf(T value, const Position& position) {
+        return Leaf{ .value = std::move(value), .x = position[0], .y = position[2], .z = position[1] };
+    }
+
+    static Placement makePlacement(T value, const Position& position) {
+        return Placement{ .x = position[0], .y = position[2], .z = position[1], .value = std::move(value) };
+    }
+
+    static TraversalValue traversalValue(
+        const Node& node, const Position& center, const Position& size, std::uint8_t level) {
+        return TraversalValue{ 
+            .node = node, 
+            .x = center[0],
+            .y = center[2],
+            .z = center[1],
+            .area_width = size[0], 
+            .area_height = size[1], 
+            .area_depth = size[2], 
+            .level = level 
+        };
+    }
+
+    static ChildrenValue childrenValue(
+        const Node& parent, const Position& center, const Position& size, std::uint8_t level) {
+        const auto offset_x = size[0]/4.F;
+        const auto offset_z = size[1]/4.F;
+        const auto offset_y = size[2]/4.F;
+        return ChildrenValue{
+            .parent = parent,
+            .coordinates = SiblingCoordinates{
+                .x = {{ center[0] - offset_x, center[0] + offset_x, center[0] - offset_x, center[0] + offset_x }},
+                .z = {{ center[1] - offset_z, center[1] - offset_z, center[1] + offset_z, center[1] + offset_z }},
+                .y = {{ center[2] - offset_y, center[2] + offset_y }}
+            },
+            .child_mask = parent.child_mask,
+            .area_width = size[0]/2.F,
+            .area_height = size[1]/2.F,
+            .area_depth = size[2]/2.F,
+            .level = static_cast<std::uint8_t>(level + 1)
+        };
+    }
+
+    static TraversalValue childValue(const Node& node, const ChildrenValue& children, std::uint32_t child) {
+        return TraversalValue{
+            .node = node,
+            .x = children.coordinates.x[child & 3U],
+            .y = children.coordinates.y[child >> 2U],
+            .z = children.coordinates.z[child & 3U],
+            .area_width = children.area_width,
+            .area_height = children.area_height,
+            .area_depth = children.area_depth,
+            .level = children.level
+        };
+    }
+};
+
+// implicit tree splitting Dimensions axes, a quad tree over x and z or an octree over x, y and z;
+// keys of leaf cells interleave the bits of cell coordinates in x, z[, y] order (Morton order)
+template<
+    typename T, 
+    std::uint8_t Height = DYNAMIC_TREE_HEIGHT, 
+    std::uint8_t Dimensions = QUAD_TREE_DIMENSIONS> 
+struct PseudoQuadTree : QuadTreeHeight<Height> {
+    static_assert(Dimensions == QUAD_TREE_DIMENSIONS || Dimensions == OCTREE_DIMENSIONS);
+    using QuadTreeHeight<Height>::tree_height_;
+    using Axes = QuadTreeAxes<T, Dimensions>;
+    using Position = typename Axes::Position;
+    using Node = typename Axes::Node;
+    using Leaf = typename Axes::Leaf;
+    using Placement = typename Axes::Placement;
+    using TraversalValue = typename Axes::TraversalValue;
+    using SiblingCoordinates = typename Axes::SiblingCoordinates;
+    using ChildrenValue = typename Axes::ChildrenValue;
+
+    static constexpr std::uint32_t CHILD_COUNT{ Node::CHILD_COUNT };
+    // bits of a key which select the child of a node
+    static constexpr std::uint32_t CHILD_KEY_MASK{ CHILD_COUNT - 1U };
+    static constexpr std::uint32_t ALL_CHILDREN{ (1U << CHILD_COUNT) - 1U };
+
+    // DENSE preallocates every node of the tree, SPARSE stores only nodes on paths 
+    // to occupied leaves with the existing children of a node stored next to each other
+    enum class Storage : std::uint8_t {
+        DENSE,
+        SPARSE
+    };
+
+    // range of leaves_ which belongs to one leaf cell, 
+    // leaf level nodes point to buckets instead of leaves
+    struct Bucket {
+        std::uint32_t first{ 0 };
+        std::uint32_t count{ 0 };
+        // slots reserved in leaves_, unused ones are skipped by traversal
+        std::uint32_t capacity{ 0 };
+    };
+
+    // what happens to placements over the bucket capacity of a cell
+    enum class BucketOverflow : std::uint8_t {
+        DROP,
+        THROW
     };
 
-    static constexpr std::uint8_t MAX_TREE_HEIGHT{ 14U };
+    // free leaf ranges are kept per capacity, one list each
+    static constexpr std::uint32_t MAX_BUCKET_CAPACITY{ 1U << 16U };
+
+    // keys of leaf cells have to fit into 32 bits
+    static constexpr std::uint8_t MAX_TREE_HEIGHT{ Dimensions == QUAD_TREE_DIMENSIONS ? 14U : 9U };
+    static_assert(Height == DYNAMIC_TREE_HEIGHT || Height <= MAX_TREE_HEIGHT);
+
+    // fixed height trees up to this one copy their initial dense heap from a table built at compile time
+    static constexpr std::uint8_t CONSTEXPR_HEAP_MAX_HEIGHT{ 5U };
 
     std::vector<Node> heap_;
     std::vector<Leaf> leaves_;
-    std::uint8_t tree_height_;
-    float area_width_;
-    float area_height_;
-    float area_world_x_pos_;
-    float area_world_z_pos_;
+    std::vector<Bucket> buckets_;
+    // set while the tree is used in place from a mapped snapshot, owned vectors are empty then
+    std::shared_ptr<const MappedFile> mapped_file_;
+    std::span<const Node> mapped_heap_;
+    std::span<const Leaf> mapped_leaves_;
+    std::span<const Bucket> mapped_buckets_;
+    std::size_t leaf_count_{ 0 };
+    // recycled buckets_ entries and leaves_ ranges indexed by their capacity
+    std::vector<std::uint32_t> free_buckets_;
+    std::vector<std::vector<std::uint32_t>> free_leaf_ranges_;
+    // size and lowest corner of the whole area per axis, in key bit order
+    Position area_size_;
+    Position area_world_pos_;
+    Storage storage_;
+    std::uint32_t bucket_capacity_;
+    BucketOverflow bucket_overflow_;
 
     PseudoQuadTree(
         std::uint8_t tree_height, 
         float area_width, 
         float area_height, 
         float area_world_x_pos,
-        float area_world_z_pos) :
-        // number elements in a heap = sum of geometrical series(a = 1, r = 4, n = tree_height + 1[+children])
-        heap_(static_cast<std::size_t>((1 * (1 - static_cast<std::int32_t>(4U << (2U*(tree_height + 1))))) / (1 - 4))),
-        tree_height_(tree_height + 1),
-        area_width_(area_width),
-        area_height_(area_height),
-        area_world_x_pos_(area_world_x_pos),
-        area_world_z_pos_(area_world_z_pos) {
-
-        // https://en.wikipedia.org/wiki/Z-order_curve
-        std::uint8_t quad_key_size{ 1U }; // 1, 2, 4, 6, 8 ...
-        std::uint64_t quad_key{ 0 };
-        std::uint64_t current_level_children_count{ 1 };
-        std::uint32_t i{ 0 };
-        float current_level_x_step{ area_width / 2.F };
-        float current_level_z_step{ area_height / 2.F };
-        for (auto& node : heap_) {
-            const auto[x, z] = decodeQuadKey(quad_key, quad_key_size);
-            node.x = current_level_x_step + static_cast<float>(2 * x) * current_level_x_step + area_world_x_pos;
-            node.z = current_level_z_step + static_cast<float>(2 * z) * current_level_z_step + area_world_z_pos;
-            node.next = 1 + (i * 4);
-            if (++quad_key == current_level_children_count) {
-                quad_key = 0;
-                current_level_children_count *= 4U;
-                current_level_x_step /= 2.F;
-                current_level_z_step /= 2.F;
-                quad_key_size += 2;
+        float area_world_z_pos,
+        Storage storage = Storage::DENSE,
+        std::uint32_t bucket_capacity = 1U,
+        BucketOverflow bucket_overflow = BucketOverflow::DROP) 
+        requires (Height == DYNAMIC_TREE_HEIGHT && Dimensions == QUAD_TREE_DIMENSIONS) :
+        PseudoQuadTree(
+            tree_height, Position{{ area_width, area_height }}, Position{{ area_world_x_pos, area_world_z_pos }},
+            storage, bucket_capacity, bucket_overflow
+        ) {
+    }
+
+    PseudoQuadTree(
+        float area_width, 
+        float area_height, 
+        float area_world_x_pos,
+        float area_world_z_pos,
+        Storage storage = Storage::DENSE,
+        std::uint32_t bucket_capacity = 1U,
+        BucketOverflow bucket_overflow = BucketOverflow::DROP) 
+        requires (Height != DYNAMIC_TREE_HEIGHT && Dimensions == QUAD_TREE_DIMENSIONS) :
+        PseudoQuadTree(
+            Height, Position{{ area_width, area_height }}, Position{{ area_world_x_pos, area_world_z_pos }},
+            storage, bucket_capacity, bucket_overflow
+        ) {
+    }
+
+    // area_depth is the size along y
+    PseudoQuadTree(
+        std::uint8_t tree_height, 
+        float area_width, 
+        float area_height, 
+        float area_depth, 
+        float area_world_x_pos,
+        float area_world_z_pos,
+        float area_world_y_pos,
+        Storage storage = Storage::DENSE,
+        std::uint32_t bucket_capacity = 1U,
+        BucketOverflow bucket_overflow = BucketOverflow::DROP) 
+        requires (Height == DYNAMIC_TREE_HEIGHT && Dimensions == OCTREE_DIMENSIONS) :
+        PseudoQuadTree(
+            tree_height, 
+            Position{{ area_width, area_height, area_depth }}, 
+            Position{{ area_world_x_pos, area_world_z_pos, area_world_y_pos }},
+            storage, bucket_capacity, bucket_overflow
+        ) {
+    }
+
+    PseudoQuadTree(
+        float area_width, 
+        float area_height, 
+        float area_depth, 
+        float area_world_x_pos,
+        float area_world_z_pos,
+        float area_world_y_pos,
+        Storage storage = Storage::DENSE,
+        std::uint32_t bucket_capacity = 1U,
+        BucketOverflow bucket_overflow = BucketOverflow::DROP) 
+        requires (Height != DYNAMIC_TREE_HEIGHT && Dimensions == OCTREE_DIMENSIONS) :
+        PseudoQuadTree(
+            Height, 
+            Position{{ area_width, area_height, area_depth }}, 
+            Position{{ area_world_x_pos, area_world_z_pos, area_world_y_pos }},
+            storage, bucket_capacity, bucket_overflow
+        ) {
+    }
+
+    // places count values at random positions, at most bucket_capacity_ per leaf cell
+    void addToRandomLeaves(T value, std::uint32_t count) {
+        std::random_device dev;
+        std::mt19937 rng(dev());
+
+        const auto last_level_extent = 1U << tree_height_;
+        const auto cell_count = std::uint64_t{ 1U } << (Dimensions * tree_height_);
+        if (leaf_count_ + count > cell_count * bucket_capacity_) {
+            throw std::invalid_argument("not enough free leaves in quad tree");
+        }
+
+        Position leaf_step{};
+        std::array<std::uniform_real_distribution<float>, Dimensions> fDist;
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            leaf_step[axis] = area_size_[axis] / static_cast<float>(last_level_extent);
+            const auto leaf_offset = leaf_step[axis]/2.F;
+            fDist[axis] = std::uniform_real_distribution<float>(
+                -leaf_offset + leaf_offset/10.F, leaf_offset - leaf_offset/10.F
+            );
+        }
+        std::uniform_int_distribution<std::uint32_t> uiDist(0U, last_level_extent - 1U);
+
+        std::vector<Placement> placements;
+        placements.reserve(leaf_count_ + count);
+        std::unordered_map<std::uint64_t, std::uint32_t> cell_fill;
+        cell_fill.reserve(leaf_count_ + count);
+        depthFirstTraversal([&](const Leaf& leaf) {
+            placements.emplace_back(Axes::makePlacement(leaf.value, Axes::position(leaf)));
+            ++cell_fill[cellKey(Axes::position(leaf)).value()];
+        });
+
+        // rejection sampling of cells which still have room
+        for (std::uint32_t i{0}; i<count;) {
+            Cell cell{};
+            for (auto& coordinate : cell) {
+                coordinate = uiDist(rng);
             }
+            auto& fill = cell_fill[encodeKey(cell)];
+            if (fill == bucket_capacity_) {
+                continue;
+            }
+            ++fill;
+            Position position{};
+            for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+                position[axis] = leaf_step[axis]/2.F + static_cast<float>(cell[axis]) * leaf_step[axis] + 
+                    area_world_pos_[axis] + fDist[axis](rng);
+            }
+            placements.emplace_back(Axes::makePlacement(value, position));
             ++i;
         }
-        // invalidate 'next' of the last level which holds leaves
-        const auto leaves_level_beginning{ static_cast<std::uint32_t>(i - current_level_children_count/4) };
-        for (std::uint32_t leaves_level_i{leaves_level_beginning}; leaves_level_i < i; ++leaves_level_i) {
-            heap_[leaves_level_i].next = Node::INVALID_NEXT;
+        build(placements);
+    }
+
+    // replaces tree content with placements, placements outside of the area are dropped
+    // and placements over bucket capacity of a cell are handled by bucket_overflow_;
+    // leaves are stored in Z-order, returns number of stored placements
+    std::size_t build(std::span<const Placement> placements) {
+        detach();
+        // quad key in upper half, placement index in lower half
+        std::vector<std::uint64_t> keys;
+        keys.reserve(placements.size());
+        for (std::size_t i{0}; i<placements.size(); ++i) {
+            const auto quad_key = cellKey(Axes::position(placements[i]));
+            if (quad_key.has_value()) {
+                keys.push_back((*quad_key << 32U) | static_cast<std::uint64_t>(i));
+            }
+        }
+        // stable, so placements within a cell keep their order
+        radixSort(keys, 32U, Dimensions * tree_height_);
+
+        // quad keys of occupied cells replace sort keys in place
+        std::vector<Bucket> buckets;
+        std::vector<std::uint32_t> selected_placements;
+        selected_placements.reserve(keys.size());
+        std::size_t cell_count{ 0 };
+        for (std::size_t i{0}; i<keys.size(); ++i) {
+            const auto quad_key = keys[i] >> 32U;
+            const auto placement_index = static_cast<std::uint32_t>(keys[i] & 0xFFFFFFFFU);
+            if (cell_count == 0 || quad_key != keys[cell_count - 1]) {
+                keys[cell_count++] = quad_key;
+                buckets.push_back(Bucket{ 
+                    .first = static_cast<std::uint32_t>(selected_placements.size()), 
+                    .count = 0U,
+                    .capacity = 0U
+                });
+            }
+            auto& bucket = buckets.back();
+            if (bucket.count == bucket_capacity_) {
+                if (bucket_overflow_ == BucketOverflow::THROW) {
+                    throw std::length_error("quad tree leaf bucket overflow");
+                }
+                continue;
+            }
+            selected_placements.push_back(placement_index);
+            ++bucket.count;
+            ++bucket.capacity;
+        }
+        keys.resize(cell_count);
+        // linked before anything is replaced so that a tree too large to link stays as it was
+        std::vector<Node> sparse_heap;
+        if (storage_ == Storage::SPARSE) {
+            sparse_heap = linkSparseLeaves(keys);
+        }
+
+        leaves_.clear();
+        leaves_.reserve(selected_placements.size());
+        for (const auto placement_index : selected_placements) {
+            const auto& placement = placements[placement_index];
+            leaves_.emplace_back(Axes::makeLeaf(placement.value, Axes::position(placement)));
+        }
+        buckets_ = std::move(buckets);
+        leaf_count_ = leaves_.size();
+        free_buckets_.clear();
+        free_leaf_ranges_.assign(bucket_capacity_ + 1U, {});
+
+        if (storage_ == Storage::DENSE) {
+            linkDenseLeaves(keys);
+        } else {
+            heap_ = std::move(sparse_heap);
         }
+        return leaf_count_;
     }
 
-    void addToRandomLeaves(T value, std::uint32_t count) {
-        std::random_device dev;
-        std::mt19937 rng(dev());
+    // quad key of the leaf cell containing x, z
+    std::optional<std::uint64_t> cellQuadKey(float x, float z) const requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return cellKey(Position{{ x, z }});
+    }
 
-        const auto last_level_extent = 2U << (tree_height_ - 1U);
+    std::optional<std::uint64_t> cellQuadKey(float x, float y, float z) const requires (Dimensions == OCTREE_DIMENSIONS) {
+        return cellKey(Position{{ x, z, y }});
+    }
 
-        std::vector<std::pair<std::uint32_t, std::uint32_t>> 
-        possible_discrete_positions(last_level_extent*last_level_extent);
-        std::uint32_t xz{0}; 
-        for (auto& position : possible_discrete_positions) {
-            position.first = xz % last_level_extent;
-            position.second = xz / last_level_extent;
-            ++xz;
+    // key of the leaf cell containing position
+    std::optional<std::uint64_t> cellKey(const Position& position) const {
+        const auto last_level_extent = static_cast<float>(1U << tree_height_);
+        Cell cell{};
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            const auto coordinate = std::floor(
+                (position[axis] - area_world_pos_[axis]) * (last_level_extent / area_size_[axis])
+            );
+            if (!(coordinate >= 0.F && coordinate < last_level_extent)) {
+                return std::nullopt;
+            }
+            cell[axis] = static_cast<std::uint32_t>(coordinate);
         }
-        std::shuffle(
-            possible_discrete_positions.begin(), 
-            possible_discrete_positions.end(),
-            rng
-        );
+        return encodeKey(cell);
+    }
 
-        const auto leaf_x_step = area_width_ / static_cast<float>(last_level_extent);
-        const auto leaf_x_offset = leaf_x_step/2.F;
+    // dynamic updates below touch only the path of the changed cell, they need DENSE storage;
+    // value and exact position identify a leaf
 
-        const auto leaf_z_step = area_height_ / static_cast<float>(last_level_extent);
-        const auto leaf_z_offset = leaf_z_step/2.F;
+    // returns false when position is outside of the area or its bucket is full and overflow is DROP
+    bool insert(float x, float z, T value) requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return insert(Position{{ x, z }}, std::move(value));
+    }
 
-        std::uniform_real_distribution<float> fDistX(
-            -leaf_x_offset + leaf_x_offset/10.F, leaf_x_offset - leaf_x_offset/10.F
-        );
-        std::uniform_real_distribution<float> fDistZ(
-            -leaf_z_offset + leaf_z_offset/10.F, leaf_z_offset - leaf_z_offset/10.F
-        );
+    bool insert(float x, float y, float z, T value) requires (Dimensions == OCTREE_DIMENSIONS) {
+        return insert(Position{{ x, z, y }}, std::move(value));
+    }
 
-        for (std::uint32_t i{0}; i<count;) {
-            const auto[rnd_ui_x, rnd_ui_z] = possible_discrete_positions.back();
-            possible_discrete_positions.pop_back();
-
-            const auto rnd_x = leaf_x_offset + static_cast<float>(rnd_ui_x) * leaf_x_step + area_world_x_pos_;
-            const auto rnd_z = leaf_z_offset + static_cast<float>(rnd_ui_z) * leaf_z_step + area_world_z_pos_;
-
-            float tmp_area_width = {area_width_/2.F};
-            float tmp_area_height = {area_height_/2.F};
-            std::uint8_t level{0};
-            for (std::uint32_t j{0}; j<heap_.size();) {
-                auto& node = heap_[j];
-
-                if (level == tree_height_) {
-                    if (node.next == Node::INVALID_NEXT) {
-                        node.next = static_cast<std::uint32_t>(leaves_.size()) + 1U;
-                        leaves_.emplace_back(Leaf{
-                            .value = value,
-                            .x = rnd_x + fDistX(rng),
-                            .z = rnd_z + fDistZ(rng)
-                        });
-                        ++i;
-                    }
+    bool remove(float x, float z, const T& value) requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return remove(Position{{ x, z }}, value);
+    }
+
+    bool remove(float x, float y, float z, const T& value) requires (Dimensions == OCTREE_DIMENSIONS) {
+        return remove(Position{{ x, z, y }}, value);
+    }
+
+    bool move(float x, float z, const T& value, float new_x, float new_z) requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return move(Position{{ x, z }}, value, Position{{ new_x, new_z }});
+    }
+
+    bool move(float x, float y, float z, const T& value, float new_x, float new_y, float new_z) 
+        requires (Dimensions == OCTREE_DIMENSIONS) {
+        return move(Position{{ x, z, y }}, value, Position{{ new_x, new_z, new_y }});
+    }
+
+    bool insert(const Position& position, T value) {
+        requireDenseStorage();
+        detach();
+        const auto quad_key = cellKey(position);
+        if (!quad_key.has_value() || !hasRoom(*quad_key)) {
+            return false;
+        }
+        auto& node = heap_[levelBeginning(tree_height_) + *quad_key];
+        if (node.next == Node::INVALID_NEXT) {
+            node.next = allocateBucket() + 1U;
+            markPath(*quad_key);
+        }
+        auto& bucket = buckets_[node.next - 1];
+        if (bucket.count == bucket.capacity) {
+            // relocated to a range which fits the whole capacity
+            const auto range = allocateLeafRange(bucket.count + 1U);
+            std::copy_n(
+                std::next(leaves_.begin(), bucket.first), bucket.count, 
+                std::next(leaves_.begin(), range.first)
+            );
+            freeLeafRange(bucket);
+            bucket.first = range.first;
+            bucket.capacity = range.capacity;
+        }
+        leaves_[bucket.first + bucket.count] = Axes::makeLeaf(std::move(value), position);
+        ++bucket.count;
+        ++leaf_count_;
+        return true;
+    }
+
+    bool remove(const Position& position, const T& value) {
+        requireDenseStorage();
+        detach();
+        const auto quad_key = cellKey(position);
+        if (!quad_key.has_value()) {
+            return false;
+        }
+        auto& node = heap_[levelBeginning(tree_height_) + *quad_key];
+        const auto leaf_index = findLeaf(node, position, value);
+        if (!leaf_index.has_value()) {
+            return false;
+        }
+        auto& bucket = buckets_[node.next - 1];
+        leaves_[*leaf_index] = std::move(leaves_[bucket.first + bucket.count - 1]);
+        --bucket.count;
+        --leaf_count_;
+        if (bucket.count == 0) {
+            freeLeafRange(bucket);
+            free_buckets_.push_back(node.next - 1);
+            node.next = Node::INVALID_NEXT;
+            clearPath(*quad_key);
+        }
+        return true;
+    }
+
+    // returns false and leaves the tree unchanged when the leaf isn't found or new position 
+    // is outside of the area or its bucket is full and overflow is DROP; for THROW a full bucket
+    // throws length_error, also before anything is changed
+    bool move(const Position& position, const T& value, const Position& new_position) {
+        requireDenseStorage();
+        detach();
+        const auto quad_key = cellKey(position);
+        const auto new_quad_key = cellKey(new_position);
+        if (!quad_key.has_value() || !new_quad_key.has_value()) {
+            return false;
+        }
+        const auto& node = heap_[levelBeginning(tree_height_) + *quad_key];
+        const auto leaf_index = findLeaf(node, position, value);
+        if (!leaf_index.has_value()) {
+            return false;
+        }
+        if (*quad_key == *new_quad_key) {
+            auto& leaf = leaves_[*leaf_index];
+            leaf = Axes::makeLeaf(std::move(leaf.value), new_position);
+            return true;
+        }
+        if (!hasRoom(*new_quad_key)) {
+            return false;
+        }
+        auto moved_value = leaves_[*leaf_index].value;
+        remove(position, value);
+        return insert(new_position, std::move(moved_value));
+    }
+
+    // rebuilds child flags and bucket links of the preallocated heap
+    void linkDenseLeaves(const std::vector<std::uint64_t>& leaf_quad_keys) {
+        for (auto& node : heap_) {
+            node.child_mask = 0U;
+        }
+        const auto leaves_level_beginning = levelBeginning(tree_height_);
+        for (auto i{leaves_level_beginning}; i < heap_.size(); ++i) {
+            heap_[i].next = Node::INVALID_NEXT;
+        }
+
+        for (std::size_t i{0}; i<leaf_quad_keys.size(); ++i) {
+            const auto quad_key = leaf_quad_keys[i];
+            heap_[leaves_level_beginning + quad_key].next = static_cast<std::uint32_t>(i) + 1U;
+
+            // mark path to the root, stop at the first ancestor shared with previous leaf
+            for (std::uint8_t level{tree_height_}; level > 0; --level) {
+                const auto shift = Dimensions * static_cast<std::uint32_t>(tree_height_ - level);
+                const auto level_quad_key = quad_key >> shift;
+                setChild(heap_[levelBeginning(level - 1U) + (level_quad_key >> Dimensions)], level_quad_key & CHILD_KEY_MASK);
+                if (i > 0 && (leaf_quad_keys[i - 1] >> (shift + Dimensions)) == (level_quad_key >> Dimensions)) {
                     break;
                 }
-                
-                const auto node_child00 = heap_[node.next + 0];
-                if (rnd_x >= node_child00.x - (tmp_area_width/2.F) && rnd_x < node_child00.x + (tmp_area_width/2.F)) {
-                    if (rnd_z >= node_child00.z - (tmp_area_height/2.F) && rnd_z < node_child00.z + (tmp_area_height/2.F)) {
-                    // in child 00
-                        node.has_child_00 = true;
-                        j = node.next + 0;
-                    } else {
-                    // in child 10
-                        node.has_child_10 = true;
-                        j = node.next + 2;
+            }
+        }
+    }
 
-                    }
-                } else {
-                    if (rnd_z >= node_child00.z - (tmp_area_height/2.F) && rnd_z < node_child00.z + (tmp_area_height/2.F)) {
-                    // in child 01
-                        node.has_child_01 = true;
-                        j = node.next + 1;
-                    } else {
-                    // in child 11
-                        node.has_child_11 = true;
-                        j = node.next + 3;
-                    }
+    // lays out only the nodes on paths to leaves, level by level, into a new heap; throws
+    // length_error when heap or bucket indices don't fit Node::next
+    std::vector<Node> linkSparseLeaves(const std::vector<std::uint64_t>& leaf_quad_keys) const {
+        static constexpr auto MAX_LINKED{ std::size_t{ 1U } << (32U - CHILD_COUNT) };
+        // bucket i is linked as i + 1
+        if (leaf_quad_keys.size() >= MAX_LINKED) {
+            throw std::length_error("sparse quad tree has too many buckets to be indexed by Node::next");
+        }
+        std::vector<Node> heap(1U);
+
+        std::vector<std::uint64_t> level_quad_keys{ 0U };
+        std::vector<std::uint64_t> child_level_quad_keys;
+        std::size_t level_beginning{ 0 };
+        for (std::uint8_t level{0}; level < tree_height_; ++level) {
+            const auto shift = Dimensions * static_cast<std::uint32_t>(tree_height_ - level - 1U);
+            child_level_quad_keys.clear();
+            std::size_t parent{ 0 };
+            for (const auto leaf_quad_key : leaf_quad_keys) {
+                const auto child_quad_key = leaf_quad_key >> shift;
+                if (!child_level_quad_keys.empty() && child_level_quad_keys.back() == child_quad_key) {
+                    continue;
+                }
+                child_level_quad_keys.push_back(child_quad_key);
+                while (level_quad_keys[parent] != (child_quad_key >> Dimensions)) {
+                    ++parent;
                 }
+                auto& parent_node = heap[level_beginning + parent];
+                if (parent_node.next == Node::INVALID_NEXT) {
+                    parent_node.next = static_cast<std::uint32_t>(heap.size());
+                }
+                setChild(parent_node, child_quad_key & CHILD_KEY_MASK);
+                heap.emplace_back();
+            }
+            if (heap.size() > MAX_LINKED) {
+                throw std::length_error("sparse quad tree is too large to be indexed by Node::next");
+            }
+            level_beginning += level_quad_keys.size();
+            level_quad_keys.swap(child_level_quad_keys);
+        }
+
+        for (std::size_t i{0}; i<level_quad_keys.size(); ++i) {
+            heap[level_beginning + i].next = static_cast<std::uint32_t>(i) + 1U;
+        }
+        return heap;
+    }
+
+    // index of the first node of a level in heap
+    static constexpr std::size_t levelBeginning(std::uint32_t level) {
+        return ((std::size_t{ 1U } << (Dimensions*level)) - 1U) / (CHILD_COUNT - 1U);
+    }
+
+    static void setChild(Node& node, std::uint64_t child) {
+        node.child_mask = (node.child_mask | (1U << child)) & ALL_CHILDREN;
+    }
 
-                ++level;
-                tmp_area_width /= 2.F;
-                tmp_area_height /= 2.F;
+    static void clearChild(Node& node, std::uint64_t child) {
+        node.child_mask = node.child_mask & ~(1U << child) & ALL_CHILDREN;
+    }
+
+    // LSD radix sort of values by bits [first_bit, first_bit + bit_count)
+    static void radixSort(std::vector<std::uint64_t>& values, std::uint32_t first_bit, std::uint32_t bit_count) {
+        static constexpr std::uint32_t radix_bits{ 11U };
+        static constexpr std::uint64_t radix_mask{ (1U << radix_bits) - 1U };
+        std::vector<std::uint64_t> sorted(values.size());
+        for (std::uint32_t bit{first_bit}; bit < first_bit + bit_count; bit += radix_bits) {
+            std::array<std::size_t, 1U << radix_bits> offsets{};
+            for (const auto value : values) {
+                ++offsets[(value >> bit) & radix_mask];
+            }
+            std::size_t offset{ 0 };
+            for (auto& bucket_offset : offsets) {
+                const auto count = bucket_offset;
+                bucket_offset = offset;
+                offset += count;
+            }
+            for (const auto value : values) {
+                sorted[offsets[(value >> bit) & radix_mask]++] = value;
             }
+            values.swap(sorted);
+        }
+    }
+
+    // inverse of decodeQuadKey, x bits go to even positions and z bits to odd ones
+    static std::uint64_t encodeQuadKey(std::uint32_t x, std::uint32_t z) {
+        const auto spread = [](std::uint64_t value) {
+            value &= 0xFFFFFFFFU;
+            value = (value | (value << 16U)) & 0x0000FFFF0000FFFFU;
+            value = (value | (value << 8U)) & 0x00FF00FF00FF00FFU;
+            value = (value | (value << 4U)) & 0x0F0F0F0F0F0F0F0FU;
+            value = (value | (value << 2U)) & 0x3333333333333333U;
+            value = (value | (value << 1U)) & 0x5555555555555555U;
+            return value;
+        };
+        return spread(x) | (spread(z) << 1U);
+    }
+
+    // cell coordinates per axis in key bit order
+    using Cell = std::array<std::uint32_t, Dimensions>;
+
+    static std::uint64_t encodeKey(const Cell& cell) {
+        if constexpr (Dimensions == QUAD_TREE_DIMENSIONS) {
+            return encodeQuadKey(cell[0], cell[1]);
+        } else {
+            const auto spread = [](std::uint64_t value) {
+                value &= 0x1FFFFFU;
+                value = (value | (value << 32U)) & 0x001F00000000FFFFU;
+                value = (value | (value << 16U)) & 0x001F0000FF0000FFU;
+                value = (value | (value << 8U)) & 0x100F00F00F00F00FU;
+                value = (value | (value << 4U)) & 0x10C30C30C30C30C3U;
+                value = (value | (value << 2U)) & 0x1249249249249249U;
+                return value;
+            };
+            return spread(cell[0]) | (spread(cell[1]) << 1U) | (spread(cell[2]) << 2U);
+        }
+    }
+
+    // number elements in a heap = sum of geometrical series(a = 1, r = CHILD_COUNT, n = tree_height + 1[+children])
+    static constexpr std::size_t heapSize(std::uint8_t tree_height) {
+        if (tree_height > MAX_TREE_HEIGHT) {
+            throw std::invalid_argument("quad tree height exceeds MAX_TREE_HEIGHT");
+        }
+        return ((std::size_t{ CHILD_COUNT } << (Dimensions*(tree_height + 1U))) - 1U) / (CHILD_COUNT - 1U);
+    }
+
+    static std::size_t initialHeapSize(std::uint8_t tree_height, Storage storage) {
+        const auto dense_heap_size = heapSize(tree_height);
+        if (storage == Storage::DENSE && dense_heap_size > (std::size_t{ 1U } << (32U - CHILD_COUNT))) {
+            throw std::invalid_argument("dense quad tree is too high to be indexed by Node::next");
+        }
+        return storage == Storage::DENSE ? dense_heap_size : 1U;
+    }
+
+    static std::uint32_t childMask(const Node& node) {
+        return node.child_mask;
+    }
+
+    // heap index of existing child (bit a of child selects the upper half of axis a) of node
+    std::uint32_t childIndex(const Node& node, std::uint32_t child) const {
+        if (storage_ == Storage::DENSE) {
+            return node.next + child;
         }
+        return node.next + static_cast<std::uint32_t>(std::popcount(childMask(node) & ((1U << child) - 1U)));
     }
 
     static auto decodeQuadKey(std::uint64_t quad_key, std::uint8_t quad_key_size) {
@@ -185,140 +1090,806 @@ template<typename T> struct PseudoQuadTree {
         return std::make_tuple(x, z);
     }
 
-    struct Iterator {
-        struct ValueType {
-            Node node;
-            float area_width;
-            float area_height;
-            std::uint8_t level;
-        };
+    struct AcceptAll {
+        constexpr bool operator()(const TraversalValue&) const {
+            return true;
+        }
+    };
 
-        const PseudoQuadTree<T>& tree_;
-        std::function<void(const Leaf&)> value_action_;
-        std::function<bool(ValueType)> predicate_;
+    struct TraversalEntry {
+        std::uint32_t index;
+        Position center;
+        Position size;
+        std::uint8_t level;
+        bool inside;
+    };
 
-        Iterator(
-            const PseudoQuadTree<T>& tree, 
-            std::function<void(const Leaf&)> value_action,
-            std::function<bool(ValueType)> predicate = nullptr) :
-            tree_(tree), 
-            value_action_(std::move(value_action)),
-            predicate_(std::move(predicate)){
+    // root of a part of the traversal which can run independently of the others
+    using Subtree = TraversalEntry;
+
+    // every popped node pushes at most CHILD_COUNT children so at most CHILD_COUNT - 1 stay 
+    // on the stack per level
+    static constexpr std::size_t TRAVERSAL_STACK_SIZE{ 
+        (CHILD_COUNT - 1U) * ((Height == DYNAMIC_TREE_HEIGHT ? MAX_TREE_HEIGHT : Height) + 1U) + 1U 
+    };
+
+    template<typename ValueAction>
+    void depthFirstTraversal(ValueAction&& value_action) const {
+        depthFirstTraversal(std::forward<ValueAction>(value_action), AcceptAll{});
+    }
+
+    // iterative, allocation free traversal; predicate returns either bool or Containment,
+    // it is evaluated once per occupied node, rejected nodes are not descended into
+    // and subtrees of INSIDE nodes are emitted without further predicate calls
+    template<typename ValueAction, typename Predicate>
+    void depthFirstTraversal(ValueAction&& value_action, Predicate&& predicate) const {
+        const auto root = rootEntry();
+        switch (classify(predicate, traversalValue(root))) {
+        case Containment::OUTSIDE: break;
+        case Containment::INTERSECTING: subtreeTraversal(root, value_action, predicate); break;
+        case Containment::INSIDE: subtreeTraversal(root, value_action, AcceptAll{}); break;
         }
+    }
 
-        void depthFirstTraversal() {
-            const auto root = ValueType{ 
-                .node = tree_.heap_.front(), 
-                .area_width = tree_.area_width_,
-                .area_height = tree_.area_height_,
-                .level = 0
-            };
-            if (predicate_ == nullptr) {
-                depthFirstTraversal(root);
-            } else {
-                if (predicate_(root)) {
-                    depthFirstTraversalWithPredicate(root);
+    // visible leaves written into buffer by group_of(leaf) < group_count, output_of(leaf) 
+    // is what is stored per leaf; culling and submission can then run apart
+    template<typename Output, typename GroupOf, typename OutputOf, typename Predicate = AcceptAll>
+    void gatherLeaves(
+        GroupedLeafBuffer<Output>& buffer, std::size_t group_count, 
+        GroupOf&& group_of, OutputOf&& output_of, Predicate&& predicate = {}) const {
+        buffer.reset(group_count);
+        depthFirstTraversal([&](const Leaf& leaf) {
+            buffer.append(group_of(leaf), output_of(leaf));
+        }, predicate);
+        buffer.finish();
+    }
+
+    // collects accepted subtrees rooted at split_level (clamped to leaf level) in depth first order, 
+    // traversing each of them with the same predicate visits the same leaves in the same order
+    // as depthFirstTraversal
+    template<typename Predicate>
+    void splitTraversal(std::uint8_t split_level, Predicate&& predicate, std::vector<Subtree>& subtrees) const {
+        subtrees.clear();
+        const auto root = rootEntry();
+        const auto root_containment = classify(predicate, traversalValue(root));
+        if (root_containment == Containment::OUTSIDE) {
+            return;
+        }
+        const auto last_level = std::min(split_level, tree_height_);
+        std::array<TraversalEntry, TRAVERSAL_STACK_SIZE> stack;
+        std::size_t stack_size{ 0 };
+        stack[stack_size] = root;
+        stack[stack_size++].inside = root_containment == Containment::INSIDE;
+
+        while (stack_size > 0) {
+            const auto entry = stack[--stack_size];
+            if (entry.level == last_level) {
+                subtrees.push_back(entry);
+                continue;
+            }
+            const auto& node = heap()[entry.index];
+            const auto child_mask = childMask(node);
+            for (std::uint32_t c{ CHILD_COUNT }; c-- > 0U;) {
+                if ((child_mask & (1U << c)) == 0U) {
+                    continue;
+                }
+                auto child = childEntry(entry, node, c);
+                child.inside = entry.inside;
+                if (!child.inside) {
+                    const auto containment = classify(predicate, traversalValue(child));
+                    if (containment == Containment::OUTSIDE) {
+                        continue;
+                    }
+                    child.inside = containment == Containment::INSIDE;
                 }
+                stack[stack_size++] = child;
             }
         }
+    }
+
+    // subtree comes from splitTraversal with the same predicate, its root isn't tested again
+    template<typename ValueAction, typename Predicate>
+    void depthFirstTraversal(const Subtree& subtree, ValueAction&& value_action, Predicate&& predicate) const {
+        subtreeTraversal(subtree, value_action, predicate);
+    }
+
+    // root as a subtree, nullopt when predicate rejects it
+    template<typename Predicate>
+    std::optional<Subtree> rootSubtree(Predicate&& predicate) const {
+        auto root = rootEntry();
+        const auto containment = classify(predicate, traversalValue(root));
+        if (containment == Containment::OUTSIDE) {
+            return std::nullopt;
+        }
+        root.inside = containment == Containment::INSIDE;
+        return root;
+    }
+
+    TraversalValue subtreeValue(const Subtree& subtree) const {
+        return traversalValue(subtree);
+    }
 
-    private:
-        void depthFirstTraversal(ValueType value) {
-            if (value.level == tree_.tree_height_) {
-                if (value.node.next != Node::INVALID_NEXT) {
-                    value_action_(tree_.leaves_[value.node.next - 1]);
+    // passes existing children of subtree's root to child_action in key order,
+    // roots at leaf level have none
+    template<typename ChildAction>
+    void forEachChild(const Subtree& subtree, ChildAction&& child_action) const {
+        if (subtree.level == tree_height_) {
+            return;
+        }
+        const auto& node = heap()[subtree.index];
+        const auto child_mask = childMask(node);
+        for (std::uint32_t c{0}; c<CHILD_COUNT; ++c) {
+            if ((child_mask & (1U << c)) != 0U) {
+                child_action(childEntry(subtree, node, c));
+            }
+        }
+    }
+
+    TraversalValue childValue(const ChildrenValue& children, std::uint32_t child) const {
+        return Axes::childValue(heap()[childIndex(children.parent, child)], children, child);
+    }
+
+    // like depthFirstTraversal but children of a node are tested at once, children_predicate 
+    // takes ChildrenValue and returns ContainmentMask, it can use SIMD on sibling coordinates
+    template<typename ValueAction, typename ChildrenPredicate>
+    void siblingDepthFirstTraversal(
+        const Subtree& subtree, ValueAction&& value_action, ChildrenPredicate&& children_predicate) const {
+        std::array<TraversalEntry, TRAVERSAL_STACK_SIZE> stack;
+        std::size_t stack_size{ 0 };
+        stack[stack_size++] = subtree;
+
+        while (stack_size > 0) {
+            const auto entry = stack[--stack_size];
+            if (entry.inside) {
+                auto subtree_root = entry;
+                subtree_root.inside = false;
+                subtreeTraversal(subtree_root, value_action, AcceptAll{});
+                continue;
+            }
+            const auto& node = heap()[entry.index];
+            if (entry.level == tree_height_) {
+                bucketTraversal(node, value_action);
+                continue;
+            }
+            const auto child_mask = childMask(node);
+            if (child_mask == 0U) {
+                continue;
+            }
+            const auto children = Axes::childrenValue(node, entry.center, entry.size, entry.level);
+            const ContainmentMask containment = children_predicate(children);
+            const auto accepted = containment.accepted & child_mask;
+            for (std::uint32_t c{ CHILD_COUNT }; c-- > 0U;) {
+                if ((accepted & (1U << c)) == 0U) {
+                    continue;
                 }
-                return;
-            }
-            if (value.node.has_child_00) {
-                depthFirstTraversal(ValueType{ 
-                    .node = tree_.heap_[value.node.next + 0],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                });
+                auto child = childEntry(entry, node, c);
+                child.inside = (containment.inside & (1U << c)) != 0U;
+                stack[stack_size++] = child;
             }
-            if (value.node.has_child_01) {
-                depthFirstTraversal(ValueType{ 
-                    .node = tree_.heap_[value.node.next + 1],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
+        }
+    }
+
+    std::span<const Node> heap() const {
+        return mapped_file_ ? mapped_heap_ : std::span<const Node>(heap_);
+    }
+
+    std::span<const Leaf> leaves() const {
+        return mapped_file_ ? mapped_leaves_ : std::span<const Leaf>(leaves_);
+    }
+
+    std::span<const Bucket> buckets() const {
+        return mapped_file_ ? mapped_buckets_ : std::span<const Bucket>(buckets_);
+    }
+
+    // leaf values are written as asset_id(value), buckets are compacted; the file is read back
+    // in place by mapSnapshot of a tree holding AssetId values
+    template<typename AssetIdOf>
+    void saveSnapshot(const std::filesystem::path& path, AssetIdOf&& asset_id) const 
+        requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        using SnapshotLeaf = typename QuadTreeAxes<AssetId, Dimensions>::Leaf;
+        const auto tree_buckets = buckets();
+        const auto tree_leaves = leaves();
+
+        std::vector<Bucket> snapshot_buckets(tree_buckets.size());
+        std::vector<SnapshotLeaf> snapshot_leaves;
+        snapshot_leaves.reserve(leaf_count_);
+        for (std::size_t i{0}; i<tree_buckets.size(); ++i) {
+            const auto& bucket = tree_buckets[i];
+            snapshot_buckets[i] = Bucket{ 
+                .first = static_cast<std::uint32_t>(snapshot_leaves.size()), 
+                .count = bucket.count, 
+                .capacity = bucket.count 
+            };
+            for (auto j{bucket.first}; j < bucket.first + bucket.count; ++j) {
+                const auto& leaf = tree_leaves[j];
+                snapshot_leaves.push_back(SnapshotLeaf{ 
+                    .value = static_cast<AssetId>(asset_id(leaf.value)), .x = leaf.x, .z = leaf.z 
                 });
             }
-            if (value.node.has_child_10) {
-                depthFirstTraversal(ValueType{ 
-                    .node = tree_.heap_[value.node.next + 2],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                });
+        }
+
+        QuadTreeSnapshotHeader header{};
+        header.tree_height = tree_height_;
+        header.storage = static_cast<std::uint8_t>(storage_);
+        header.node_size = sizeof(Node);
+        header.leaf_size = sizeof(SnapshotLeaf);
+        header.area_width = area_size_[0];
+        header.area_height = area_size_[1];
+        header.area_world_x_pos = area_world_pos_[0];
+        header.area_world_z_pos = area_world_pos_[1];
+        header.bucket_capacity = bucket_capacity_;
+        header.bucket_overflow = static_cast<std::uint32_t>(bucket_overflow_);
+        header.leaf_count = snapshot_leaves.size();
+        header.node_count = heap().size();
+        header.nodes_offset = snapshotAlign(sizeof(QuadTreeSnapshotHeader));
+        header.bucket_count = snapshot_buckets.size();
+        header.buckets_offset = snapshotAlign(header.nodes_offset + header.node_count * sizeof(Node));
+        header.leaves_offset = snapshotAlign(header.buckets_offset + header.bucket_count * sizeof(Bucket));
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        if (!stream.good()) {
+            throw std::runtime_error("failed to create quad tree snapshot " + path.string());
+        }
+        const auto write = [&stream](std::uint64_t offset, const void* data, std::size_t size) {
+            static constexpr std::array<char, SNAPSHOT_ALIGNMENT> PADDING{};
+            stream.write(PADDING.data(), static_cast<std::streamsize>(offset - static_cast<std::uint64_t>(stream.tellp())));
+            stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+        write(0U, &header, sizeof(header));
+        write(header.nodes_offset, heap().data(), header.node_count * sizeof(Node));
+        write(header.buckets_offset, snapshot_buckets.data(), header.bucket_count * sizeof(Bucket));
+        write(header.leaves_offset, snapshot_leaves.data(), header.leaf_count * sizeof(SnapshotLeaf));
+        if (!stream.good()) {
+            throw std::runtime_error("failed to write quad tree snapshot " + path.string());
+        }
+    }
+
+    // maps the snapshot and traverses it in place, the first modification copies it into owned 
+    // storage; bucket settings, node links, buckets and asset ids (below asset_count) are validated
+    // while mapping, which reads nodes, buckets and leaves once
+    static PseudoQuadTree mapSnapshot(const std::filesystem::path& path, AssetId asset_count) 
+        requires (std::is_same_v<T, AssetId> && Dimensions == QUAD_TREE_DIMENSIONS) {
+        auto file = std::make_shared<const MappedFile>(path);
+        const auto bytes = file->bytes();
+        QuadTreeSnapshotHeader header{};
+        if (bytes.size() < sizeof(header)) {
+            throw std::runtime_error("quad tree snapshot is truncated " + path.string());
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != QuadTreeSnapshotHeader::MAGIC) {
+            throw std::runtime_error("not a quad tree snapshot " + path.string());
+        }
+        if (header.endian_tag != QuadTreeSnapshotHeader::ENDIAN_TAG) {
+            throw std::runtime_error("quad tree snapshot has different byte order " + path.string());
+        }
+        if (header.version != QuadTreeSnapshotHeader::VERSION || header.storage > 1U ||
+            header.node_size != sizeof(Node) || header.leaf_size != sizeof(Leaf)) {
+            throw std::runtime_error("unsupported quad tree snapshot version " + path.string());
+        }
+        if (header.tree_height == 0U || header.tree_height > MAX_TREE_HEIGHT + 1U || 
+            (Height != DYNAMIC_TREE_HEIGHT && header.tree_height != Height + 1U)) {
+            throw std::runtime_error("quad tree snapshot height doesn't match " + path.string());
+        }
+        // checked here since the constructor reports them as invalid arguments
+        if (header.bucket_capacity == 0U || header.bucket_capacity > MAX_BUCKET_CAPACITY ||
+            header.bucket_overflow > static_cast<std::uint32_t>(BucketOverflow::THROW)) {
+            throw std::runtime_error("quad tree snapshot is corrupt " + path.string());
+        }
+        const auto section = [&]<typename Element>(std::uint64_t offset, std::uint64_t count) {
+            if (offset % alignof(Element) != 0U || offset > bytes.size() || 
+                count > (bytes.size() - offset) / sizeof(Element)) {
+                throw std::runtime_error("quad tree snapshot is truncated " + path.string());
             }
-            if (value.node.has_child_11) {
-                depthFirstTraversal(ValueType{ 
-                    .node = tree_.heap_[value.node.next + 3],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                });
+            return std::span<const Element>(
+                reinterpret_cast<const Element*>(bytes.data() + offset), static_cast<std::size_t>(count) // NOLINT
+            );
+        };
+
+        const auto storage = static_cast<Storage>(header.storage);
+        auto tree = [&] {
+            // constructed sparse so that nothing gets allocated for the mapped heap
+            if constexpr (Height == DYNAMIC_TREE_HEIGHT) {
+                return PseudoQuadTree(
+                    static_cast<std::uint8_t>(header.tree_height - 1U), 
+                    header.area_width, header.area_height, header.area_world_x_pos, header.area_world_z_pos,
+                    Storage::SPARSE, header.bucket_capacity, static_cast<BucketOverflow>(header.bucket_overflow)
+                );
+            } else {
+                return PseudoQuadTree(
+                    header.area_width, header.area_height, header.area_world_x_pos, header.area_world_z_pos,
+                    Storage::SPARSE, header.bucket_capacity, static_cast<BucketOverflow>(header.bucket_overflow)
+                );
             }
+        }();
+        tree.storage_ = storage;
+        tree.heap_.clear();
+        tree.mapped_heap_ = section.template operator()<Node>(header.nodes_offset, header.node_count);
+        tree.mapped_buckets_ = section.template operator()<Bucket>(header.buckets_offset, header.bucket_count);
+        tree.mapped_leaves_ = section.template operator()<Leaf>(header.leaves_offset, header.leaf_count);
+        tree.leaf_count_ = static_cast<std::size_t>(header.leaf_count);
+        tree.mapped_file_ = std::move(file);
+        if (!tree.validSnapshot(asset_count)) {
+            throw std::runtime_error("quad tree snapshot is corrupt " + path.string());
         }
-        void depthFirstTraversalWithPredicate(ValueType value) {
-            if (value.level == tree_.tree_height_) {
-                if (value.node.next != Node::INVALID_NEXT && predicate_(value)) {
-                    value_action_(tree_.leaves_[value.node.next - 1]);
+        return tree;
+    }
+
+    const Leaf& leaf(std::uint32_t leaf_index) const {
+        return leaves()[leaf_index];
+    }
+
+    // writes indices (see leaf()) of leaves within radius of x, z into result, returns how many 
+    // leaves matched, which may be more than result can hold
+    std::size_t radiusQuery(float x, float z, float radius, std::span<std::uint32_t> result) const 
+        requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return radiusQuery(Position{{ x, z }}, radius, result);
+    }
+
+    std::size_t radiusQuery(float x, float y, float z, float radius, std::span<std::uint32_t> result) const 
+        requires (Dimensions == OCTREE_DIMENSIONS) {
+        return radiusQuery(Position{{ x, z, y }}, radius, result);
+    }
+
+    std::size_t radiusQuery(const Position& position, float radius, std::span<std::uint32_t> result) const {
+        const auto radius2 = radius * radius;
+        std::size_t count{ 0 };
+        depthFirstTraversal(
+            [&](const Leaf& candidate) {
+                if (pointDistance2(position, Axes::position(candidate)) <= radius2) {
+                    if (count < result.size()) {
+                        result[count] = static_cast<std::uint32_t>(&candidate - leaves().data());
+                    }
+                    ++count;
                 }
-                return;
-            }
-            if (value.node.has_child_00) {
-                const auto new_value = ValueType{ 
-                    .node = tree_.heap_[value.node.next + 0],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                };
-                if (predicate_(new_value)) {
-                    depthFirstTraversalWithPredicate(new_value);
+            },
+            [&](const TraversalValue& value) {
+                const auto center = Axes::center(value);
+                const auto size = Axes::size(value);
+                if (nearestDistance2(position, center, size) > radius2) {
+                    return Containment::OUTSIDE;
                 }
+                return furthestDistance2(position, center, size) <= radius2 ? 
+                    Containment::INSIDE : Containment::INTERSECTING;
             }
-            if (value.node.has_child_01) {
-                const auto new_value = ValueType{ 
-                    .node = tree_.heap_[value.node.next + 1],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                };
-                if (predicate_(new_value)) {
-                    depthFirstTraversalWithPredicate(new_value);
+        );
+        return count;
+    }
+
+    // best first search, writes indices of up to result.size() leaves nearest to x, z 
+    // into result ordered by distance, returns how many were written
+    std::size_t nearestQuery(float x, float z, std::span<std::uint32_t> result) const 
+        requires (Dimensions == QUAD_TREE_DIMENSIONS) {
+        return nearestQuery(Position{{ x, z }}, result);
+    }
+
+    std::size_t nearestQuery(float x, float y, float z, std::span<std::uint32_t> result) const 
+        requires (Dimensions == OCTREE_DIMENSIONS) {
+        return nearestQuery(Position{{ x, z, y }}, result);
+    }
+
+    std::size_t nearestQuery(const Position& position, std::span<std::uint32_t> result) const {
+        if (result.empty()) {
+            return 0U;
+        }
+        // leaf entries keep leaf index in node.index
+        struct QueueEntry {
+            float distance2;
+            TraversalEntry node;
+            bool is_leaf;
+
+            bool operator>(const QueueEntry& other) const {
+                return distance2 > other.distance2;
+            }
+        };
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+        const auto root = rootEntry();
+        queue.push(QueueEntry{ nearestDistance2(position, root.center, root.size), root, false });
+
+        std::size_t count{ 0 };
+        while (!queue.empty() && count < result.size()) {
+            const auto entry = queue.top();
+            queue.pop();
+            if (entry.is_leaf) {
+                result[count++] = entry.node.index;
+                continue;
+            }
+            const auto& node = heap()[entry.node.index];
+            if (entry.node.level == tree_height_) {
+                if (node.next != Node::INVALID_NEXT) {
+                    const auto& bucket = buckets()[node.next - 1];
+                    for (auto i{bucket.first}; i < bucket.first + bucket.count; ++i) {
+                        auto leaf_entry = entry.node;
+                        leaf_entry.index = i;
+                        queue.push(QueueEntry{ 
+                            pointDistance2(position, Axes::position(leaves()[i])), leaf_entry, true 
+                        });
+                    }
                 }
+                continue;
             }
-            if (value.node.has_child_10) {
-                const auto new_value = ValueType{ 
-                    .node = tree_.heap_[value.node.next + 2],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                };
-                if (predicate_(new_value)) {
-                    depthFirstTraversalWithPredicate(new_value);
+            const auto child_mask = childMask(node);
+            for (std::uint32_t c{0}; c<CHILD_COUNT; ++c) {
+                if ((child_mask & (1U << c)) == 0U) {
+                    continue;
                 }
+                const auto child = childEntry(entry.node, node, c);
+                queue.push(QueueEntry{ nearestDistance2(position, child.center, child.size), child, false });
             }
-            if (value.node.has_child_11) {
-                const auto new_value = ValueType{ 
-                    .node = tree_.heap_[value.node.next + 3],
-                    .area_width = value.area_width/2.F, 
-                    .area_height = value.area_height/2.F,
-                    .level = static_cast<std::uint8_t>(value.level + 1)
-                };
-                if (predicate_(new_value)) {
-                    depthFirstTraversalWithPredicate(new_value);
+        }
+        return count;
+    }
+
+private:
+    static constexpr std::size_t SNAPSHOT_ALIGNMENT{ 16U };
+
+    static constexpr std::uint64_t snapshotAlign(std::uint64_t offset) {
+        return (offset + SNAPSHOT_ALIGNMENT - 1U) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    }
+
+    // tree_height is ignored when Height is fixed
+    PseudoQuadTree(
+        std::uint8_t tree_height,
+        const Position& area_size,
+        const Position& area_world_pos,
+        Storage storage,
+        std::uint32_t bucket_capacity,
+        BucketOverflow bucket_overflow) :
+        QuadTreeHeight<Height>(treeHeight(tree_height)),
+        heap_(initialHeapSize(tree_height, storage)),
+        area_size_(area_size),
+        area_world_pos_(area_world_pos),
+        storage_(storage),
+        bucket_capacity_(bucket_capacity),
+        bucket_overflow_(bucket_overflow) {
+        init();
+    }
+
+    static QuadTreeHeight<Height> treeHeight(std::uint8_t tree_height) {
+        if constexpr (Height == DYNAMIC_TREE_HEIGHT) {
+            return QuadTreeHeight<Height>{ static_cast<std::uint8_t>(tree_height + 1U) };
+        } else {
+            return QuadTreeHeight<Height>{};
+        }
+    }
+
+    // copies a mapped snapshot into owned storage
+    void detach() {
+        if (!mapped_file_) {
+            return;
+        }
+        heap_.assign(mapped_heap_.begin(), mapped_heap_.end());
+        leaves_.assign(mapped_leaves_.begin(), mapped_leaves_.end());
+        buckets_.assign(mapped_buckets_.begin(), mapped_buckets_.end());
+        mapped_heap_ = {};
+        mapped_leaves_ = {};
+        mapped_buckets_ = {};
+        mapped_file_.reset();
+    }
+
+    void init() {
+        if (bucket_capacity_ == 0U || bucket_capacity_ > MAX_BUCKET_CAPACITY) {
+            throw std::invalid_argument("quad tree bucket capacity has to be between 1 and MAX_BUCKET_CAPACITY");
+        }
+        free_leaf_ranges_.resize(bucket_capacity_ + 1U);
+
+        if (storage_ == Storage::SPARSE) {
+            return;
+        }
+        if constexpr (Height != DYNAMIC_TREE_HEIGHT && Height <= CONSTEXPR_HEAP_MAX_HEIGHT) {
+            static constexpr auto INITIAL_DENSE_HEAP = initialDenseHeap<heapSize(Height)>();
+            std::copy(INITIAL_DENSE_HEAP.begin(), INITIAL_DENSE_HEAP.end(), heap_.begin());
+            return;
+        }
+
+        // 'next' of the last level which holds leaves stays invalid
+        const auto leaves_level_beginning = levelBeginning(tree_height_);
+        for (std::size_t i{0}; i<leaves_level_beginning; ++i) {
+            heap_[i].next = static_cast<std::uint32_t>(1U + (i * CHILD_COUNT));
+        }
+    }
+
+    // links of a mapped snapshot have to be laid out as linkDenseLeaves/linkSparseLeaves lay them
+    // out, so that traversal never indexes past the heap, buckets or leaves
+    bool validSnapshot(AssetId asset_count) const {
+        const auto nodes = heap();
+        const auto snapshot_buckets = buckets();
+        const auto snapshot_leaves = leaves();
+        const auto leaves_level_beginning = storage_ == Storage::DENSE ? levelBeginning(tree_height_) : 0U;
+        if (storage_ == Storage::DENSE) {
+            if (nodes.size() != heapSize(static_cast<std::uint8_t>(tree_height_ - 1U))) {
+                return false;
+            }
+            for (std::size_t i{0}; i<leaves_level_beginning; ++i) {
+                if (nodes[i].next != 1U + (i * CHILD_COUNT)) {
+                    return false;
+                }
+            }
+        }
+
+        // sparse children of a level follow each other in parent order right after the level
+        std::size_t level_beginning{ 0 };
+        std::size_t level_end{ nodes.empty() ? 0U : 1U };
+        for (std::uint8_t level{0}; storage_ == Storage::SPARSE && level < tree_height_; ++level) {
+            auto next = level_end;
+            for (auto i{level_beginning}; i < level_end; ++i) {
+                const auto child_count = static_cast<std::size_t>(std::popcount(childMask(nodes[i])));
+                if (child_count > 0U && nodes[i].next != next) {
+                    return false;
+                }
+                next += child_count;
+            }
+            if (next > nodes.size()) {
+                return false;
+            }
+            level_beginning = level_end;
+            level_end = next;
+        }
+
+        const auto leaf_nodes = storage_ == Storage::DENSE ? 
+            nodes.subspan(leaves_level_beginning) : nodes.subspan(level_beginning, level_end - level_beginning);
+        for (const auto& node : leaf_nodes) {
+            if (node.next != Node::INVALID_NEXT && node.next > snapshot_buckets.size()) {
+                return false;
+            }
+        }
+        for (const auto& bucket : snapshot_buckets) {
+            if (bucket.count > bucket.capacity || bucket.capacity > bucket_capacity_ || 
+                bucket.first > snapshot_leaves.size() || 
+                bucket.capacity > snapshot_leaves.size() - bucket.first) {
+                return false;
+            }
+        }
+        return std::all_of(snapshot_leaves.begin(), snapshot_leaves.end(), [asset_count](const Leaf& leaf) {
+            return leaf.value < asset_count;
+        });
+    }
+
+    template<std::size_t HeapSize>
+    static constexpr std::array<Node, HeapSize> initialDenseHeap() {
+        std::array<Node, HeapSize> heap{};
+        for (std::size_t i{0}; i<levelBeginning(tree_height_); ++i) {
+            heap[i].next = static_cast<std::uint32_t>(1U + (i * CHILD_COUNT));
+        }
+        return heap;
+    }
+
+    static float pointDistance2(const Position& p0, const Position& p1) {
+        float distance2{ 0.F };
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            distance2 += (p1[axis] - p0[axis]) * (p1[axis] - p0[axis]);
+        }
+        return distance2;
+    }
+
+    // squared distance from position to the closest point of node's area
+    static float nearestDistance2(const Position& position, const Position& center, const Position& size) {
+        float distance2{ 0.F };
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            const auto d = std::max(std::abs(position[axis] - center[axis]) - size[axis]/2.F, 0.F);
+            distance2 += d * d;
+        }
+        return distance2;
+    }
+
+    static float furthestDistance2(const Position& position, const Position& center, const Position& size) {
+        float distance2{ 0.F };
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            const auto d = std::abs(position[axis] - center[axis]) + size[axis]/2.F;
+            distance2 += d * d;
+        }
+        return distance2;
+    }
+
+    struct LeafRange {
+        std::uint32_t first;
+        std::uint32_t capacity;
+    };
+
+    void requireDenseStorage() const {
+        if (storage_ != Storage::DENSE) {
+            throw std::logic_error("quad tree dynamic updates need DENSE storage");
+        }
+    }
+
+    // false when bucket of the cell is full and overflow is DROP, throws for THROW
+    bool hasRoom(std::uint64_t quad_key) const {
+        const auto& node = heap_[levelBeginning(tree_height_) + quad_key];
+        if (node.next == Node::INVALID_NEXT || buckets_[node.next - 1].count < bucket_capacity_) {
+            return true;
+        }
+        if (bucket_overflow_ == BucketOverflow::THROW) {
+            throw std::length_error("quad tree leaf bucket overflow");
+        }
+        return false;
+    }
+
+    std::optional<std::uint32_t> findLeaf(const Node& node, const Position& position, const T& value) const {
+        if (node.next == Node::INVALID_NEXT) {
+            return std::nullopt;
+        }
+        const auto& bucket = buckets_[node.next - 1];
+        for (auto i{bucket.first}; i < bucket.first + bucket.count; ++i) {
+            const auto& leaf = leaves_[i];
+            if (Axes::position(leaf) == position && leaf.value == value) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::uint32_t allocateBucket() {
+        const auto range = allocateLeafRange(1U);
+        const auto bucket = Bucket{ .first = range.first, .count = 0U, .capacity = range.capacity };
+        if (free_buckets_.empty()) {
+            buckets_.push_back(bucket);
+            return static_cast<std::uint32_t>(buckets_.size() - 1U);
+        }
+        const auto bucket_index = free_buckets_.back();
+        free_buckets_.pop_back();
+        buckets_[bucket_index] = bucket;
+        return bucket_index;
+    }
+
+    // largest recycled range of at least min_capacity slots, new full capacity range otherwise
+    LeafRange allocateLeafRange(std::uint32_t min_capacity) {
+        for (auto capacity{bucket_capacity_}; capacity >= min_capacity; --capacity) {
+            auto& free_ranges = free_leaf_ranges_[capacity];
+            if (!free_ranges.empty()) {
+                const auto first = free_ranges.back();
+                free_ranges.pop_back();
+                return LeafRange{ first, capacity };
+            }
+        }
+        const auto first = static_cast<std::uint32_t>(leaves_.size());
+        leaves_.resize(leaves_.size() + bucket_capacity_);
+        return LeafRange{ first, bucket_capacity_ };
+    }
+
+    void freeLeafRange(const Bucket& bucket) {
+        if (bucket.capacity > 0U) {
+            free_leaf_ranges_[bucket.capacity].push_back(bucket.first);
+        }
+    }
+
+    // sets child flags up to the first ancestor which already had the flag
+    void markPath(std::uint64_t quad_key) {
+        for (std::uint8_t level{tree_height_}; level > 0; --level) {
+            const auto level_quad_key = quad_key >> (Dimensions * static_cast<std::uint32_t>(tree_height_ - level));
+            auto& parent = heap_[levelBeginning(level - 1U) + (level_quad_key >> Dimensions)];
+            const auto had_children = childMask(parent) != 0U;
+            setChild(parent, level_quad_key & CHILD_KEY_MASK);
+            if (had_children) {
+                break;
+            }
+        }
+    }
+
+    // clears child flags up to the first ancestor which still has other children
+    void clearPath(std::uint64_t quad_key) {
+        for (std::uint8_t level{tree_height_}; level > 0; --level) {
+            const auto level_quad_key = quad_key >> (Dimensions * static_cast<std::uint32_t>(tree_height_ - level));
+            auto& parent = heap_[levelBeginning(level - 1U) + (level_quad_key >> Dimensions)];
+            clearChild(parent, level_quad_key & CHILD_KEY_MASK);
+            if (childMask(parent) != 0U) {
+                break;
+            }
+        }
+    }
+
+    TraversalValue traversalValue(const TraversalEntry& entry) const {
+        return Axes::traversalValue(heap()[entry.index], entry.center, entry.size, entry.level);
+    }
+
+    template<typename ValueAction>
+    void bucketTraversal(const Node& node, ValueAction& value_action) const {
+        if (node.next != Node::INVALID_NEXT) {
+            const auto& bucket = buckets()[node.next - 1];
+            for (auto i{bucket.first}; i < bucket.first + bucket.count; ++i) {
+                value_action(leaves()[i]);
+            }
+        }
+    }
+
+    TraversalEntry rootEntry() const {
+        auto root = TraversalEntry{ 0U, area_world_pos_, area_size_, 0U, false };
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            root.center[axis] += area_size_[axis]/2.F;
+        }
+        return root;
+    }
+
+    // child c lies in the upper half of axis a when bit a of c is set
+    TraversalEntry childEntry(const TraversalEntry& entry, const Node& node, std::uint32_t child) const {
+        auto child_entry = TraversalEntry{ 
+            childIndex(node, child), entry.center, {}, static_cast<std::uint8_t>(entry.level + 1), false 
+        };
+        for (std::size_t axis{0}; axis<Dimensions; ++axis) {
+            child_entry.size[axis] = entry.size[axis]/2.F;
+            child_entry.center[axis] += ((child >> axis) & 1U) != 0U ? 
+                child_entry.size[axis]/2.F : -child_entry.size[axis]/2.F;
+        }
+        return child_entry;
+    }
+
+    template<typename ValueAction, typename Predicate>
+    void subtreeTraversal(const TraversalEntry& root, ValueAction& value_action, Predicate&& predicate) const {
+        std::array<TraversalEntry, TRAVERSAL_STACK_SIZE> stack;
+        std::size_t stack_size{ 0 };
+        stack[stack_size++] = root;
+
+        while (stack_size > 0) {
+            const auto entry = stack[--stack_size];
+            if (entry.inside) {
+                auto subtree_root = entry;
+                subtree_root.inside = false;
+                subtreeTraversal(subtree_root, value_action, AcceptAll{});
+                continue;
+            }
+            const auto& node = heap()[entry.index];
+
+            if (entry.level == tree_height_) {
+                bucketTraversal(node, value_action);
+                continue;
+            }
+
+            const auto child_mask = childMask(node);
+            // pushed in reverse so children are visited in key order
+            for (std::uint32_t c{ CHILD_COUNT }; c-- > 0U;) {
+                if ((child_mask & (1U << c)) == 0U) {
+                    continue;
+                }
+                auto child = childEntry(entry, node, c);
+                const auto containment = classify(predicate, traversalValue(child));
+                if (containment != Containment::OUTSIDE) {
+                    child.inside = containment == Containment::INSIDE;
+                    stack[stack_size++] = child;
                 }
             }
         }
+    }
+
+public:
+    struct Iterator {
+        using ValueType = TraversalValue;
+
+        const PseudoQuadTree& tree_;
+        std::function<void(const Leaf&)> value_action_;
+        std::function<bool(ValueType)> predicate_;
+        std::function<Containment(ValueType)> containment_predicate_;
 
+        Iterator(
+            const PseudoQuadTree& tree, 
+            std::function<void(const Leaf&)> value_action,
+            std::function<bool(ValueType)> predicate = nullptr) :
+            tree_(tree), 
+            value_action_(std::move(value_action)),
+            predicate_(std::move(predicate)){
+        }
+
+        Iterator(
+            const PseudoQuadTree& tree, 
+            std::function<void(const Leaf&)> value_action,
+            std::function<Containment(ValueType)> containment_predicate) :
+            tree_(tree), 
+            value_action_(std::move(value_action)),
+            containment_predicate_(std::move(containment_predicate)){
+        }
+
+        void depthFirstTraversal() {
+            if (containment_predicate_ != nullptr) {
+                tree_.depthFirstTraversal(value_action_, containment_predicate_);
+            } else if (predicate_ != nullptr) {
+                tree_.depthFirstTraversal(value_action_, predicate_);
+            } else {
+                tree_.depthFirstTraversal(value_action_);
+            }
+        }
     };
 };
 
+template<typename T, std::uint8_t Height = DYNAMIC_TREE_HEIGHT> 
+using PseudoOctree = PseudoQuadTree<T, Height, OCTREE_DIMENSIONS>;
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef RW_CUBE_RENDER_QUEUE_HPP
+#define RW_CUBE_RENDER_QUEUE_HPP
+
+#include <cinttypes>
+#include <vector>
+
+#include <Model.hpp>
+
+namespace rw_cube {
+
+// state and parameters of one non instanced draw
+struct DrawPacket {
+	std::uint64_t key;
+	std::uint32_t program_id;
+	// vertex array with its element buffer attached for indexed draws
+	std::uint32_t vao_id;
+	std::uint32_t texture_id;
+	std::uint32_t texture_unit;
+	// index count of indexed draws, vertex count otherwise
+	std::uint32_t count;
+	bool indexed;
+	// ObjectBuffer object and offset the draw selects
+	std::uint32_t object;
+	Model::InstanceOffset offset;
+};
+
+// draws collected during a frame are radix sorted by their keys and submitted in that order,
+// program, vertex array and texture are bound only when they differ from the previous draw's,
+// so submission costs one pass over the packets however many shaders and models a scene has
+struct RenderQueue {
+	// key fields from the most significant bits: pass, program, vertex array, texture, depth;
+	// ids wider than their field share keys with other ids and only group worse
+	static constexpr std::uint32_t PASS_BITS{ 4U };
+	static constexpr std::uint32_t PROGRAM_BITS{ 12U };
+	static constexpr std::uint32_t VAO_BITS{ 12U };
+	static constexpr std::uint32_t TEXTURE_BITS{ 12U };
+	static constexpr std::uint32_t DEPTH_BITS{ 24U };
+
+	// binds of the last submit
+	struct Stats {
+		std::uint32_t draws{ 0 };
+		std::uint32_t program_binds{ 0 };
+		std::uint32_t vao_binds{ 0 };
+		std::uint32_t texture_binds{ 0 };
+	};
+
+	struct SortEntry {
+		std::uint64_t key;
+		std::uint32_t packet;
+	};
+
+	std::vector<DrawPacket> packets_;
+	std::vector<SortEntry> entries_;
+	std::vector<SortEntry> sort_scratch_;
+	Stats stats_{};
+
+	// depth is clamped to [0, 1], lower depth sorts first within equal state
+	static std::uint64_t sortKey(
+		std::uint32_t pass, std::uint32_t program_id, std::uint32_t vao_id, std::uint32_t texture_id, float depth);
+
+	void clear();
+	void push(const DrawPacket& packet);
+	// sorts the packets and draws them, the queue keeps them until clear
+	void submit();
+	void sort();
+};
+
+}
+
+#endif
@@ -23,6 +23,19 @@ struct Shader {
 	void deinit();
 };
 
+struct ComputeShader {
+	std::uint32_t prog_id_;
+	std::uint32_t shader_id_;
+
+	ComputeShader(bool is_spirv, const std::filesystem::path& path);
+
+	void bind() const;
+	// binds the program and runs group_count_x work groups
+	void dispatch(std::uint32_t group_count_x) const;
+
+	void deinit();
+};
+
 } // namespace rw_cube
 
 #endif
\ No newline at end of file
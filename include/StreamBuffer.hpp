@@ -0,0 +1,45 @@
+#ifndef RW_CUBE_STREAM_BUFFER_HPP
+#define RW_CUBE_STREAM_BUFFER_HPP
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace rw_cube {
+
+// persistently mapped buffer split into one region per frame in flight, data of a frame is
+// copied into its region and bound by range; a fence per region makes the frame that reuses it
+// wait until the GPU has read it, so writes never stall on buffers still in use
+struct StreamBuffer {
+	std::uint32_t buffer_id_{ 0 };
+	std::uint32_t target_;
+	std::size_t region_size_;
+	std::uint32_t region_count_;
+	std::size_t offset_alignment_;
+	std::byte* mapped_{ nullptr };
+	// GLsync of the last frame written into each region
+	std::vector<void*> fences_;
+	std::uint32_t region_{ 0 };
+	// next free byte of the current region
+	std::size_t region_offset_{ 0 };
+
+	// target is the binding target ranges are bound to (GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER)
+	StreamBuffer(std::uint32_t target, std::size_t region_size, std::uint32_t region_count = 3U);
+
+	// offsets of bound ranges have to be multiples of it
+	static std::size_t offsetAlignment(std::uint32_t target);
+
+	// moves to the next region, waits only when the GPU is still reading it
+	void beginFrame();
+	// copies data into the current region and returns its offset in the buffer,
+	// throws when the region is full
+	std::size_t push(const void* data, std::size_t size);
+	void bindRange(std::uint32_t binding, std::size_t offset, std::size_t size) const;
+	// fences the current region after the frame's draws were issued
+	void endFrame();
+	void deinit();
+};
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef RW_CUBE_THREAD_POOL_HPP
+#define RW_CUBE_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rw_cube {
+
+struct ThreadPool {
+	using Task = std::function<void(std::size_t task_index, std::size_t thread_index)>;
+
+	explicit ThreadPool(std::size_t worker_count);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	~ThreadPool();
+
+	// workers and the calling thread
+	[[nodiscard]] std::size_t threadCount() const;
+
+	// calls task for every index in [0, task_count) and returns once all calls finished,
+	// calling thread takes part with thread index threadCount() - 1
+	void run(std::size_t task_count, const Task& task);
+
+	void deinit();
+
+private:
+	void work(std::size_t thread_index);
+	void runTasks(std::size_t thread_index);
+
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable start_cv_;
+	std::condition_variable done_cv_;
+	const Task* task_{ nullptr };
+	std::size_t task_count_{ 0 };
+	std::atomic<std::size_t> next_task_{ 0 };
+	std::size_t generation_{ 0 };
+	std::size_t busy_workers_{ 0 };
+	bool stop_{ false };
+};
+
+}
+
+#endif
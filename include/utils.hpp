@@ -16,7 +16,8 @@ void setVertexArrayLayout(
     std::uint32_t vao_id,
     std::uint32_t vbo_id,
     std::uint32_t attrib_binding,
-    const std::vector<AttribConfig>& attrib_configs
+    const std::vector<AttribConfig>& attrib_configs,
+    std::uint32_t divisor = 0
 );
 
 }
@@ -2,9 +2,8 @@
 
 layout(location = 0) in vec3 in_position;
 
-layout(std140, binding = 0) uniform MVP {
+layout(std140, binding = 0) uniform Frame {
     mat4 vp;
-    mat4 m_position;
     vec3 light_pos;
     float ambient_light;
     vec3 camera_pos;
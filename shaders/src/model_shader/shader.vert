@@ -3,27 +3,35 @@
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec2 in_texcoord;
 layout(location = 2) in vec3 in_normal;
+layout(location = 3) in vec3 in_offset;
+layout(location = 4) in uint in_object;
 
-layout(std140, binding = 0) uniform MVP {
+layout(std140, binding = 0) uniform Frame {
     mat4 vp;
-    mat4 m_position;
     vec3 light_pos;
     float ambient_light;
     vec3 camera_pos;
-    vec3 ambient;
-    float shininess;
-    vec3 diffuse;
-    float alpha;
-    vec3 specular;
+};
+
+struct Object {
+    mat4 model;
+    uint material;
+};
+
+layout(std430, binding = 4) readonly buffer Objects {
+    Object objects[];
 };
 
 layout(location = 0) out vec2 out_texcoord;
 layout(location = 1) out vec3 out_normal;
 layout(location = 2) out vec3 out_position;
+layout(location = 3) flat out uint out_material;
 
 void main() {
+    Object object = objects[in_object];
     out_texcoord = in_texcoord.xy;
-    out_normal = mat3(m_position) * in_normal;
-    out_position = vec3(m_position * vec4(in_position, 1.0));
-    gl_Position = vp * m_position * vec4(in_position, 1.0);
+    out_normal = mat3(object.model) * in_normal;
+    out_position = vec3(object.model * vec4(in_position, 1.0)) + in_offset;
+    out_material = object.material;
+    gl_Position = vp * vec4(out_position, 1.0);
 }
@@ -4,9 +4,8 @@ layout(location = 0) out vec4 out_fragment;
 
 layout(binding = 1) uniform sampler2DArray u_tex_array;
 
-layout(std140, binding = 0) uniform MVP {
+layout(std140, binding = 0) uniform Frame {
     mat4 vp;
-    mat4 m_position;
     vec3 light_pos;
     float ambient_light;
     vec3 camera_pos;
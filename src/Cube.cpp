@@ -1,5 +1,6 @@
 #include "Cube.hpp"
 #include "CubeTexture.hpp"
+#include "GlState.hpp"
 #include "utils.hpp"
 
 #include <cstring>
@@ -81,7 +82,7 @@ Cube::Cube(
 		++i;
 	}
 	glGenerateTextureMipmap(tex_id_);
-	glBindTextureUnit(SHCONFIG_2D_TEX_ARRAY_BINDING, tex_id_);
+	GlState::bindTextureUnit(SHCONFIG_2D_TEX_ARRAY_BINDING, tex_id_);
 }
 
 std::tuple<float, float, float> Cube::rotate(float x, float y, float z) {
@@ -101,7 +102,7 @@ void Cube::draw() const {
 	glDrawArrays(GL_TRIANGLES, 0, INDICES.size());
 }
 void Cube::bind() const {
-	glBindVertexArray(vao_id_);
+	GlState::bindVertexArray(vao_id_);
 }
 void Cube::deinit() {
 	for (auto shader : shaders) {
@@ -109,4 +110,5 @@ void Cube::deinit() {
 	}
 	glDeleteBuffers(1, &vbo_id_);
 	glDeleteVertexArrays(1, &vao_id_);
+	GlState::invalidate();
 }
\ No newline at end of file
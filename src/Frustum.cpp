@@ -0,0 +1,220 @@
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define RW_CUBE_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace rw_cube;
+
+// NOLINTBEGIN
+Frustum::Frustum(const mat4x4 vp) {
+    // vp[column][row], plane = row 3 +/- row 0..2
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto row = i / 2;
+        const auto sign = (i % 2 == 0) ? 1.F : -1.F;
+        const auto a = vp[0][3] + sign * vp[0][row];
+        const auto b = vp[1][3] + sign * vp[1][row];
+        const auto c = vp[2][3] + sign * vp[2][row];
+        const auto d = vp[3][3] + sign * vp[3][row];
+        const auto length = std::sqrt(a*a + b*b + c*c);
+        a_[i] = a / length;
+        b_[i] = b / length;
+        c_[i] = c / length;
+        d_[i] = d / length;
+    }
+}
+// NOLINTEND
+
+bool Frustum::intersectsBox(
+    float center_x, float center_y, float center_z,
+    float extent_x, float extent_y, float extent_z) const {
+    // box is outside when its corner furthest along the plane normal is behind the plane
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto distance =
+            a_[i] * center_x + b_[i] * center_y + c_[i] * center_z + d_[i] +
+            std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z;
+        if (distance < 0.F) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Containment Frustum::classifyBox(
+    float center_x, float center_y, float center_z,
+    float extent_x, float extent_y, float extent_z) const {
+    auto result = Containment::INSIDE;
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto center_distance = a_[i] * center_x + b_[i] * center_y + c_[i] * center_z + d_[i];
+        const auto projected_extent = 
+            std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z;
+        if (center_distance + projected_extent < 0.F) {
+            return Containment::OUTSIDE;
+        }
+        // nearest corner behind the plane
+        if (center_distance - projected_extent < 0.F) {
+            result = Containment::INTERSECTING;
+        }
+    }
+    return result;
+}
+
+// NOLINTBEGIN
+StableContainment Frustum::classifyBoxStable(
+    float center_x, float center_y, float center_z,
+    float extent_x, float extent_y, float extent_z,
+    const vec3 camera_position, float rotation_reach) const {
+    // a plane's distance to a box corner changes by at most the camera motion scaled by how far 
+    // the corner is from the camera
+    bool outside{ false };
+    bool intersecting{ false };
+    float outside_margin{ 0.F };
+    auto accepted_margin = std::numeric_limits<float>::max();
+    auto inside_margin = std::numeric_limits<float>::max();
+    float intersecting_margin{ 0.F };
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto center_distance = a_[i] * center_x + b_[i] * center_y + c_[i] * center_z + d_[i];
+        const auto projected_extent = 
+            std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z;
+        const auto far_distance = center_distance + projected_extent;
+        const auto near_distance = center_distance - projected_extent;
+        if (far_distance < 0.F) {
+            outside = true;
+            outside_margin = std::max(outside_margin, -far_distance);
+        }
+        accepted_margin = std::min(accepted_margin, far_distance);
+        if (near_distance < 0.F) {
+            intersecting = true;
+            intersecting_margin = std::max(intersecting_margin, -near_distance);
+        } else {
+            inside_margin = std::min(inside_margin, near_distance);
+        }
+    }
+    auto result = outside ? 
+        StableContainment{ Containment::OUTSIDE, outside_margin } : intersecting ?
+        StableContainment{ Containment::INTERSECTING, std::min(accepted_margin, intersecting_margin) } :
+        StableContainment{ Containment::INSIDE, inside_margin };
+
+    const auto dx = center_x - camera_position[0];
+    const auto dy = center_y - camera_position[1];
+    const auto dz = center_z - camera_position[2];
+    const auto reach = 
+        std::sqrt(dx*dx + dy*dy + dz*dz) + 
+        std::sqrt(extent_x*extent_x + extent_y*extent_y + extent_z*extent_z);
+    if (reach > rotation_reach) {
+        result.margin *= rotation_reach / reach;
+    }
+    return result;
+}
+// NOLINTEND
+
+std::uint32_t Frustum::intersectsBoxes4(
+    const std::array<float, 4>& center_x,
+    const std::array<float, 4>& center_z,
+    float center_y,
+    float extent_x, float extent_y, float extent_z) const {
+#ifdef RW_CUBE_FRUSTUM_SSE
+    const auto xs = _mm_loadu_ps(center_x.data());
+    const auto zs = _mm_loadu_ps(center_z.data());
+    auto inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        // part of the distance which is the same for all 4 boxes
+        const auto shared =
+            b_[i] * center_y + d_[i] +
+            std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z;
+        const auto distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a_[i]), xs), _mm_mul_ps(_mm_set1_ps(c_[i]), zs)),
+            _mm_set1_ps(shared)
+        );
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+    }
+    return static_cast<std::uint32_t>(_mm_movemask_ps(inside));
+#else
+    std::uint32_t mask{ 0 };
+    for (std::uint32_t i{0}; i<4; ++i) {
+        if (intersectsBox(center_x[i], center_y, center_z[i], extent_x, extent_y, extent_z)) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+std::uint32_t Frustum::intersectsBoxes4(
+    const std::array<float, 4>& center_x,
+    const std::array<float, 4>& center_y,
+    const std::array<float, 4>& center_z,
+    float extent_x, float extent_y, float extent_z) const {
+#ifdef RW_CUBE_FRUSTUM_SSE
+    const auto xs = _mm_loadu_ps(center_x.data());
+    const auto ys = _mm_loadu_ps(center_y.data());
+    const auto zs = _mm_loadu_ps(center_z.data());
+    auto inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto shared =
+            d_[i] + std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z;
+        const auto distance = _mm_add_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a_[i]), xs), _mm_mul_ps(_mm_set1_ps(b_[i]), ys)),
+                _mm_mul_ps(_mm_set1_ps(c_[i]), zs)
+            ),
+            _mm_set1_ps(shared)
+        );
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+    }
+    return static_cast<std::uint32_t>(_mm_movemask_ps(inside));
+#else
+    std::uint32_t mask{ 0 };
+    for (std::uint32_t i{0}; i<4; ++i) {
+        if (intersectsBox(center_x[i], center_y[i], center_z[i], extent_x, extent_y, extent_z)) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+ContainmentMask Frustum::classifyBoxes4(
+    const std::array<float, 4>& center_x,
+    const std::array<float, 4>& center_z,
+    float center_y,
+    float extent_x, float extent_y, float extent_z) const {
+#ifdef RW_CUBE_FRUSTUM_SSE
+    const auto xs = _mm_loadu_ps(center_x.data());
+    const auto zs = _mm_loadu_ps(center_z.data());
+    auto accepted = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+    auto inside = accepted;
+    for (std::size_t i{0}; i<PLANE_COUNT; ++i) {
+        const auto projected_extent = _mm_set1_ps(
+            std::abs(a_[i]) * extent_x + std::abs(b_[i]) * extent_y + std::abs(c_[i]) * extent_z
+        );
+        const auto center_distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a_[i]), xs), _mm_mul_ps(_mm_set1_ps(c_[i]), zs)),
+            _mm_set1_ps(b_[i] * center_y + d_[i])
+        );
+        accepted = _mm_and_ps(accepted, _mm_cmpge_ps(_mm_add_ps(center_distance, projected_extent), _mm_setzero_ps()));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(center_distance, projected_extent), _mm_setzero_ps()));
+    }
+    return ContainmentMask{ 
+        .accepted = static_cast<std::uint32_t>(_mm_movemask_ps(accepted)),
+        .inside = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_and_ps(accepted, inside)))
+    };
+#else
+    ContainmentMask mask{};
+    for (std::uint32_t i{0}; i<4; ++i) {
+        const auto containment = classifyBox(center_x[i], center_y, center_z[i], extent_x, extent_y, extent_z);
+        if (containment != Containment::OUTSIDE) {
+            mask.accepted |= 1U << i;
+        }
+        if (containment == Containment::INSIDE) {
+            mask.inside |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+}
@@ -0,0 +1,135 @@
+#include "GlState.hpp"
+
+#include <array>
+#include <limits>
+
+#include <glad/glad.h>
+
+using namespace rw_cube;
+
+namespace {
+
+constexpr std::uint32_t UNKNOWN{ std::numeric_limits<std::uint32_t>::max() };
+constexpr std::size_t CACHED_TEXTURE_UNITS{ 32U };
+constexpr std::size_t CACHED_BUFFER_BINDINGS{ 16U };
+
+struct BufferBinding {
+	std::uint32_t buffer_id{ UNKNOWN };
+	std::size_t offset{ 0 };
+	// 0 for a whole buffer bound with glBindBufferBase
+	std::size_t size{ 0 };
+
+	bool operator==(const BufferBinding&) const = default;
+};
+
+using BufferBindings = std::array<BufferBinding, CACHED_BUFFER_BINDINGS>;
+
+struct CachedState {
+	std::uint32_t program_id{ UNKNOWN };
+	std::uint32_t vao_id{ UNKNOWN };
+	std::array<std::uint32_t, CACHED_TEXTURE_UNITS> textures{};
+	BufferBindings uniform_buffers{};
+	BufferBindings storage_buffers{};
+	std::array<std::int32_t, 4> viewport{{ -1, -1, -1, -1 }};
+
+	CachedState() {
+		textures.fill(UNKNOWN);
+	}
+};
+
+CachedState state;
+GlState::Counters counters;
+
+// updates cached value and returns true when the call has to be issued
+template<typename Value>
+bool change(Value& cached, const Value& value) {
+	if (cached == value) {
+		++counters.elided;
+		return false;
+	}
+	cached = value;
+	++counters.issued;
+	return true;
+}
+
+BufferBinding* cachedBinding(std::uint32_t target, std::uint32_t binding) {
+	if (binding >= CACHED_BUFFER_BINDINGS) {
+		return nullptr;
+	}
+	switch (target) {
+	case GL_UNIFORM_BUFFER: return &state.uniform_buffers[binding];
+	case GL_SHADER_STORAGE_BUFFER: return &state.storage_buffers[binding];
+	default: return nullptr;
+	}
+}
+
+}
+
+void GlState::useProgram(std::uint32_t program_id) {
+	if (change(state.program_id, program_id)) {
+		glUseProgram(program_id);
+	}
+}
+
+void GlState::bindVertexArray(std::uint32_t vao_id) {
+	if (change(state.vao_id, vao_id)) {
+		glBindVertexArray(vao_id);
+	}
+}
+
+void GlState::bindTextureUnit(std::uint32_t unit, std::uint32_t texture_id) {
+	if (unit >= CACHED_TEXTURE_UNITS) {
+		++counters.issued;
+		glBindTextureUnit(unit, texture_id);
+		return;
+	}
+	if (change(state.textures[unit], texture_id)) {
+		glBindTextureUnit(unit, texture_id);
+	}
+}
+
+void GlState::bindBufferBase(std::uint32_t target, std::uint32_t binding, std::uint32_t buffer_id) {
+	auto* cached = cachedBinding(target, binding);
+	if (cached == nullptr) {
+		++counters.issued;
+		glBindBufferBase(target, binding, buffer_id);
+		return;
+	}
+	if (change(*cached, BufferBinding{ .buffer_id = buffer_id, .offset = 0U, .size = 0U })) {
+		glBindBufferBase(target, binding, buffer_id);
+	}
+}
+
+void GlState::bindBufferRange(
+	std::uint32_t target, std::uint32_t binding, std::uint32_t buffer_id, std::size_t offset, std::size_t size) {
+	const auto issue = [&] {
+		glBindBufferRange(
+			target, binding, buffer_id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size)
+		);
+	};
+	auto* cached = cachedBinding(target, binding);
+	if (cached == nullptr) {
+		++counters.issued;
+		issue();
+		return;
+	}
+	if (change(*cached, BufferBinding{ .buffer_id = buffer_id, .offset = offset, .size = size })) {
+		issue();
+	}
+}
+
+void GlState::viewport(std::int32_t x, std::int32_t y, std::int32_t width, std::int32_t height) {
+	if (change(state.viewport, std::array<std::int32_t, 4>{{ x, y, width, height }})) {
+		glViewport(x, y, width, height);
+	}
+}
+
+void GlState::invalidate() {
+	state = CachedState{};
+}
+
+GlState::Counters GlState::takeCounters() {
+	const auto taken = counters;
+	counters = {};
+	return taken;
+}
@@ -0,0 +1,137 @@
+#include "GpuCulling.hpp"
+#include "GlState.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <glad/glad.h>
+
+using namespace rw_cube;
+
+// layouts shared with shaders/src/culling_shader/shader.comp
+static_assert(sizeof(GpuCulling::Object) == 16U);
+static_assert(sizeof(GpuCulling::DrawElementsIndirectCommand) == 20U);
+static_assert(offsetof(GpuCulling::CullingData, camera_pos) == 96U);
+static_assert(offsetof(GpuCulling::CullingData, object_count) == 112U);
+
+namespace {
+
+struct Mesh {
+	std::array<float, 4> bounds_min;
+	std::array<float, 4> bounds_max;
+};
+
+std::uint32_t createBuffer(GLsizeiptr size, const void* data, GLbitfield flags) {
+	std::uint32_t buffer_id{ 0 };
+	glCreateBuffers(1, &buffer_id);
+	glNamedBufferStorage(buffer_id, size, data, flags);
+	return buffer_id;
+}
+
+}
+
+GpuCulling::GpuCulling(bool is_spirv, std::span<Model* const> meshes, std::span<const Object> objects) :
+	object_count_(static_cast<std::uint32_t>(objects.size())),
+	mesh_count_(static_cast<std::uint32_t>(meshes.size())),
+	culling_shader_(is_spirv, is_spirv ? "shaders/bin/culling_shader/comp.spv" : "shaders/src/culling_shader/shader.comp") {
+	// every mesh gets room for all of its objects
+	std::vector<DrawElementsIndirectCommand> commands(meshes.size());
+	for (const auto& object : objects) {
+		if (object.mesh >= meshes.size()) {
+			throw std::invalid_argument("gpu culling object refers to a missing mesh");
+		}
+		++commands[object.mesh].base_instance;
+	}
+	std::uint32_t base_instance{ 0 };
+	std::vector<Mesh> mesh_bounds;
+	mesh_bounds.reserve(meshes.size());
+	for (std::size_t i{0}; i<meshes.size(); ++i) {
+		const auto object_count = commands[i].base_instance;
+		commands[i] = DrawElementsIndirectCommand{
+			.count = meshes[i]->indices_count_,
+			.instance_count = 0U,
+			.first_index = 0U,
+			.base_vertex = 0,
+			.base_instance = base_instance
+		};
+		base_instance += object_count;
+		const auto& min = meshes[i]->bounds_min_;
+		const auto& max = meshes[i]->bounds_max_;
+		mesh_bounds.push_back({ {{ min[0], min[1], min[2], 0.F }}, {{ max[0], max[1], max[2], 0.F }} });
+	}
+
+	// buffers can't be empty
+	objects_ssbo_id_ = createBuffer(
+		static_cast<GLsizeiptr>(std::max<std::size_t>(objects.size_bytes(), sizeof(Object))), nullptr, GL_DYNAMIC_STORAGE_BIT
+	);
+	glNamedBufferSubData(objects_ssbo_id_, 0, static_cast<GLsizeiptr>(objects.size_bytes()), objects.data());
+	meshes_ssbo_id_ = createBuffer(
+		static_cast<GLsizeiptr>(std::max<std::size_t>(mesh_bounds.size(), 1U) * sizeof(Mesh)), nullptr, GL_DYNAMIC_STORAGE_BIT
+	);
+	glNamedBufferSubData(
+		meshes_ssbo_id_, 0, static_cast<GLsizeiptr>(mesh_bounds.size() * sizeof(Mesh)), mesh_bounds.data()
+	);
+	const auto commands_size = static_cast<GLsizeiptr>(
+		std::max<std::size_t>(commands.size(), 1U) * sizeof(DrawElementsIndirectCommand)
+	);
+	commands.resize(std::max<std::size_t>(commands.size(), 1U));
+	commands_buffer_id_ = createBuffer(commands_size, commands.data(), 0);
+	empty_commands_buffer_id_ = createBuffer(commands_size, commands.data(), 0);
+	instances_buffer_id_ = createBuffer(
+		static_cast<GLsizeiptr>(std::max(object_count_, 1U) * sizeof(Model::InstanceOffset)), nullptr, 0
+	);
+	culling_ubo_id_ = createBuffer(sizeof(CullingData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+void GpuCulling::cull(const Frustum& frustum, const std::array<float, 3>& camera_pos, float view_distance) const {
+	CullingData data{ .planes = {}, .camera_pos = camera_pos, .view_distance = view_distance, .object_count = object_count_ };
+	for (std::size_t i{0}; i<Frustum::PLANE_COUNT; ++i) {
+		data.planes[i] = {{ frustum.a_[i], frustum.b_[i], frustum.c_[i], frustum.d_[i] }};
+	}
+	glNamedBufferSubData(culling_ubo_id_, 0, sizeof(CullingData), &data);
+	glCopyNamedBufferSubData(
+		empty_commands_buffer_id_, commands_buffer_id_, 0, 0, 
+		static_cast<GLsizeiptr>(mesh_count_ * sizeof(DrawElementsIndirectCommand))
+	);
+
+	GlState::bindBufferBase(GL_UNIFORM_BUFFER, SHCONFIG_CULLING_UBO_BINDING, culling_ubo_id_);
+	GlState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, SHCONFIG_CULLING_OBJECTS_BINDING, objects_ssbo_id_);
+	GlState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, SHCONFIG_CULLING_MESHES_BINDING, meshes_ssbo_id_);
+	GlState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, SHCONFIG_CULLING_COMMANDS_BINDING, commands_buffer_id_);
+	GlState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, SHCONFIG_CULLING_INSTANCES_BINDING, instances_buffer_id_);
+	culling_shader_.dispatch((object_count_ + WORK_GROUP_SIZE - 1U) / WORK_GROUP_SIZE);
+	// commands are read by the indirect draw and reset by the next cull's copy, 
+	// instances are read as vertex attributes
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuCulling::draw(std::span<Model* const> meshes) const {
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_buffer_id_);
+	for (std::size_t i{0}; i<meshes.size() && i<mesh_count_; ++i) {
+		meshes[i]->bindInstanced(instances_buffer_id_);
+		glDrawElementsIndirect(
+			GL_TRIANGLES, 
+			GL_UNSIGNED_INT, 
+			reinterpret_cast<const void*>(i * sizeof(DrawElementsIndirectCommand)) // NOLINT
+		);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GpuCulling::deinit() {
+	std::array<std::uint32_t, 6> buffers{{
+		objects_ssbo_id_, meshes_ssbo_id_, commands_buffer_id_, 
+		empty_commands_buffer_id_, instances_buffer_id_, culling_ubo_id_
+	}};
+	glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+	objects_ssbo_id_ = 0;
+	meshes_ssbo_id_ = 0;
+	commands_buffer_id_ = 0;
+	empty_commands_buffer_id_ = 0;
+	instances_buffer_id_ = 0;
+	culling_ubo_id_ = 0;
+	culling_shader_.deinit();
+	GlState::invalidate();
+}
@@ -0,0 +1,79 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace rw_cube;
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+	size_ = static_cast<std::size_t>(std::filesystem::file_size(path));
+	if (size_ == 0U) {
+		throw std::runtime_error(fmt::format("failed to map empty file {}", path.string()));
+	}
+#ifdef _WIN32
+	file_handle_ = CreateFileW(
+		path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+	);
+	if (file_handle_ == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error(fmt::format("failed to open file {}", path.string()));
+	}
+	mapping_handle_ = CreateFileMappingW(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle_ == nullptr) {
+		CloseHandle(file_handle_);
+		throw std::runtime_error(fmt::format("failed to map file {}", path.string()));
+	}
+	data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr) {
+		CloseHandle(mapping_handle_);
+		CloseHandle(file_handle_);
+		throw std::runtime_error(fmt::format("failed to map file {}", path.string()));
+	}
+#else
+	const auto fd = open(path.c_str(), O_RDONLY); // NOLINT
+	if (fd == -1) {
+		throw std::runtime_error(fmt::format("failed to open file {}", path.string()));
+	}
+	auto* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	// mapping stays valid after the descriptor is closed
+	close(fd);
+	if (data == MAP_FAILED) { // NOLINT
+		throw std::runtime_error(fmt::format("failed to map file {}", path.string()));
+	}
+	data_ = static_cast<const std::byte*>(data);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_handle_);
+	CloseHandle(file_handle_);
+#else
+	munmap(const_cast<std::byte*>(data_), size_); // NOLINT
+#endif
+}
+
+std::span<const std::byte> MappedFile::bytes() const {
+	return { data_, size_ };
+}
+
+void MappedFile::prefault() const {
+	static constexpr std::size_t PAGE_SIZE{ 4096U };
+	volatile std::byte sink{};
+	for (std::size_t offset{0}; offset < size_; offset += PAGE_SIZE) {
+		sink = data_[offset]; // NOLINT
+	}
+	static_cast<void>(sink);
+}
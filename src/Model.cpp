@@ -1,6 +1,9 @@
 #include <Model.hpp>
+#include <GlState.hpp>
+#include <ObjectBuffer.hpp>
 #include <utils.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <array>
@@ -159,6 +162,10 @@ Model::Model(bool is_spirv, const std::filesystem::path& obj_path, const std::fi
     model_shader_(is_spirv, {
         is_spirv ? "shaders/bin/model_shader/vert.spv" : "shaders/src/model_shader/shader.vert",
         is_spirv ? "shaders/bin/model_shader/frag.spv" : "shaders/src/model_shader/shader.frag" 
+    }),
+    model_instanced_shader_(is_spirv, {
+        is_spirv ? "shaders/bin/model_instanced_shader/vert.spv" : "shaders/src/model_instanced_shader/shader.vert",
+        is_spirv ? "shaders/bin/model_shader/frag.spv" : "shaders/src/model_shader/shader.frag" 
     }){
 
     std::ifstream stream(obj_path.string());
@@ -329,6 +336,17 @@ Model::Model(bool is_spirv, const std::filesystem::path& obj_path, const std::fi
 
     indices_count_ = num_indices;
 
+    if (!positions.empty()) {
+        bounds_min_ = {{ positions[0], positions[1], positions[2] }};
+        bounds_max_ = bounds_min_;
+    }
+    for (std::size_t i{0}; i + 2 < positions.size(); i += 3) {
+        for (std::size_t axis{0}; axis<3; ++axis) {
+            bounds_min_[axis] = std::min(bounds_min_[axis], positions[i + axis]);
+            bounds_max_[axis] = std::max(bounds_max_[axis], positions[i + axis]);
+        }
+    }
+
     std::vector<std::uint32_t> indices(num_indices);
     std::vector<float> vertices; 
     vertices.reserve(vertices_to_indices.size() * (3 + 2 + 3));
@@ -375,17 +393,43 @@ Model::Model(bool is_spirv, const std::filesystem::path& obj_path, const std::fi
         0
     );
 
-    glCreateVertexArrays(1, &vao_id_);
+    std::array<std::uint32_t, 2> vertex_arrays{{0, 0}};
+    glCreateVertexArrays(static_cast<GLsizei>(vertex_arrays.size()), vertex_arrays.data());
+
+    vao_id_ = vertex_arrays[0];
+    instanced_vao_id_ = vertex_arrays[1];
+
+    for (const auto vertex_array : vertex_arrays) {
+        setVertexArrayLayout(
+            vertex_array,
+            vbo_id_,
+            VERTEX_BINDING, 
+            {
+                {SHCONFIG_IN_POSITION_LOCATION, 3},
+                {SHCONFIG_IN_TEXCOORD_LOCATION, 2},
+                {SHCONFIG_IN_NORMAL_LOCATION, 3}
+            }
+        );
+        glVertexArrayElementBuffer(vertex_array, ebo_id_);
+    }
 
+    static constexpr std::uint32_t initial_instance_capacity{ 64 };
+    instance_capacity_ = initial_instance_capacity;
+    glCreateBuffers(1, &instance_vbo_id_);
+    glNamedBufferStorage(
+        instance_vbo_id_,
+        static_cast<GLsizeiptr>(instance_capacity_ * sizeof(InstanceOffset)),
+        nullptr,
+        GL_DYNAMIC_STORAGE_BIT
+    );
     setVertexArrayLayout(
-        vao_id_,
-        vbo_id_,
-        0U, 
+        instanced_vao_id_,
+        instance_vbo_id_,
+        INSTANCE_BINDING,
         {
-            {SHCONFIG_IN_POSITION_LOCATION, 3},
-            {SHCONFIG_IN_TEXCOORD_LOCATION, 2},
-            {SHCONFIG_IN_NORMAL_LOCATION, 3}
-        }
+            {SHCONFIG_IN_OFFSET_LOCATION, 3}
+        },
+        1U
     );
 
     glCreateTextures(GL_TEXTURE_2D, 1, &tex_id_);
@@ -426,7 +470,7 @@ Model::Model(bool is_spirv, const std::filesystem::path& obj_path, const std::fi
         static_cast<const void*>(img.data())
     );
     glGenerateTextureMipmap(tex_id_);
-    glBindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, tex_id_);
+    GlState::bindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, tex_id_);
 
     model_material_ = loadMaterial(mtllib_path);
 }
@@ -437,19 +481,101 @@ void Model::draw() const {
 
 void Model::bind() const {
     model_shader_.bind();
-    glBindVertexArray(vao_id_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id_);
+    GlState::bindVertexArray(vao_id_);
+    GlState::bindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, tex_id_);
+    ObjectBuffer::select(object_id_);
+}
+
+void Model::sendInstanceData(std::span<const InstanceOffset> offsets) {
+    reserveInstances(static_cast<std::uint32_t>(offsets.size()), 0U);
+    glNamedBufferSubData(
+        instance_vbo_id_,
+        0,
+        static_cast<GLsizeiptr>(offsets.size_bytes()),
+        static_cast<const void*>(offsets.data())
+    );
 }
+
+void Model::sendInstanceData(std::span<const InstanceOffset> offsets, std::uint32_t first) {
+    reserveInstances(first + static_cast<std::uint32_t>(offsets.size()), first);
+    glNamedBufferSubData(
+        instance_vbo_id_,
+        static_cast<GLintptr>(first * sizeof(InstanceOffset)),
+        static_cast<GLsizeiptr>(offsets.size_bytes()),
+        static_cast<const void*>(offsets.data())
+    );
+}
+
+void Model::reserveInstances(std::uint32_t count, std::uint32_t kept_count) {
+    if (count <= instance_capacity_) {
+        return;
+    }
+    // buffer storage is immutable so bigger one has to be created
+    while (instance_capacity_ < count) {
+        instance_capacity_ *= 2;
+    }
+    std::uint32_t buffer_id{ 0 };
+    glCreateBuffers(1, &buffer_id);
+    glNamedBufferStorage(
+        buffer_id,
+        static_cast<GLsizeiptr>(instance_capacity_ * sizeof(InstanceOffset)),
+        nullptr,
+        GL_DYNAMIC_STORAGE_BIT
+    );
+    if (kept_count > 0) {
+        glCopyNamedBufferSubData(
+            instance_vbo_id_, buffer_id, 0, 0, static_cast<GLsizeiptr>(kept_count * sizeof(InstanceOffset))
+        );
+    }
+    glDeleteBuffers(1, &instance_vbo_id_);
+    instance_vbo_id_ = buffer_id;
+    glVertexArrayVertexBuffer(
+        instanced_vao_id_, INSTANCE_BINDING, instance_vbo_id_, 0, sizeof(InstanceOffset)
+    );
+}
+
+void Model::drawInstanced(std::uint32_t instance_count) const {
+    glDrawElementsInstanced(
+        GL_TRIANGLES, 
+        indices_count_, 
+        GL_UNSIGNED_INT, 
+        nullptr, 
+        static_cast<GLsizei>(instance_count)
+    );
+}
+
+void Model::bindInstanced() const {
+    bindInstanced(instance_vbo_id_);
+}
+
+void Model::bindInstanced(std::uint32_t instance_buffer_id) const {
+    glVertexArrayVertexBuffer(
+        instanced_vao_id_, INSTANCE_BINDING, instance_buffer_id, 0, sizeof(InstanceOffset)
+    );
+    model_instanced_shader_.bind();
+    GlState::bindVertexArray(instanced_vao_id_);
+    GlState::bindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, tex_id_);
+    ObjectBuffer::select(object_id_);
+}
+
 void Model::deinit() {
-    std::array<std::uint32_t, 2> buffers{{vbo_id_, ebo_id_}};
+    std::array<std::uint32_t, 3> buffers{{vbo_id_, ebo_id_, instance_vbo_id_}};
     glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
     vbo_id_ = 0;
     ebo_id_ = 0;
+    instance_vbo_id_ = 0;
+    instance_capacity_ = 0;
+
+    model_shader_.deinit();
+    model_instanced_shader_.deinit();
 
-    glBindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, 0);
+    GlState::bindTextureUnit(SHCONFIG_2D_MODEL_TEX_BINDING, 0);
     glDeleteTextures(1, &tex_id_);
     tex_id_ = 0;
 
-    glDeleteVertexArrays(1, &vao_id_);
+    std::array<std::uint32_t, 2> vertex_arrays{{vao_id_, instanced_vao_id_}};
+    glDeleteVertexArrays(static_cast<GLsizei>(vertex_arrays.size()), vertex_arrays.data());
     vao_id_ = 0;
+    instanced_vao_id_ = 0;
+    GlState::invalidate();
 }
\ No newline at end of file
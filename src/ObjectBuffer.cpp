@@ -0,0 +1,113 @@
+#include "ObjectBuffer.hpp"
+#include "GlState.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+using namespace rw_cube;
+
+static_assert(sizeof(ObjectBuffer::Object) == 80U, "Object has to match the std430 layout of the shaders");
+static_assert(sizeof(Model::Material) == 48U, "Material has to match the std430 layout of the shaders");
+
+namespace {
+
+std::uint32_t createStorage(std::uint32_t binding, std::size_t size) {
+	std::uint32_t buffer_id{ 0 };
+	glCreateBuffers(1, &buffer_id);
+	glNamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	GlState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer_id);
+	return buffer_id;
+}
+
+template<typename Element>
+void uploadRange(std::uint32_t buffer_id, const std::vector<Element>& elements, ObjectBuffer::DirtyRange& range) {
+	if (range.first == range.last) {
+		return;
+	}
+	glNamedBufferSubData(
+		buffer_id,
+		static_cast<GLintptr>(range.first * sizeof(Element)),
+		static_cast<GLsizeiptr>((range.last - range.first) * sizeof(Element)),
+		static_cast<const void*>(&elements[range.first])
+	);
+	range = {};
+}
+
+}
+
+void ObjectBuffer::DirtyRange::add(std::uint32_t index) {
+	if (first == last) {
+		first = index;
+		last = index + 1U;
+		return;
+	}
+	first = std::min(first, index);
+	last = std::max(last, index + 1U);
+}
+
+ObjectBuffer::ObjectBuffer(std::uint32_t object_capacity, std::uint32_t material_capacity) :
+	object_capacity_(std::max(object_capacity, 1U)),
+	material_capacity_(std::max(material_capacity, 1U)) {
+	objects_.reserve(object_capacity_);
+	materials_.reserve(material_capacity_);
+	objects_id_ = createStorage(SHCONFIG_OBJECTS_BINDING, object_capacity_ * sizeof(Object));
+	materials_id_ = createStorage(SHCONFIG_MATERIALS_BINDING, material_capacity_ * sizeof(Model::Material));
+}
+
+std::uint32_t ObjectBuffer::addMaterial(const Model::Material& material) {
+	if (materials_.size() == material_capacity_) {
+		throw std::length_error("object buffer material table is full");
+	}
+	const auto index = static_cast<std::uint32_t>(materials_.size());
+	materials_.push_back(material);
+	dirty_materials_.add(index);
+	return index;
+}
+
+std::uint32_t ObjectBuffer::addObject(const mat4x4 model, std::uint32_t material) { // NOLINT
+	if (objects_.size() == object_capacity_) {
+		throw std::length_error("object buffer is full");
+	}
+	if (material >= materials_.size()) {
+		throw std::out_of_range("object refers to a material which wasn't added");
+	}
+	const auto index = static_cast<std::uint32_t>(objects_.size());
+	auto& object = objects_.emplace_back(Object{ .model = {}, .material = material, .padding_ = {} });
+	mat4x4_dup(object.model, model);
+	dirty_objects_.add(index);
+	return index;
+}
+
+void ObjectBuffer::setObject(std::uint32_t object, const mat4x4 model) { // NOLINT
+	auto& object_model = objects_.at(object).model;
+	if (std::memcmp(object_model, model, sizeof(mat4x4)) == 0) {
+		return;
+	}
+	mat4x4_dup(object_model, model);
+	dirty_objects_.add(object);
+}
+
+void ObjectBuffer::upload() {
+	uploadRange(objects_id_, objects_, dirty_objects_);
+	uploadRange(materials_id_, materials_, dirty_materials_);
+}
+
+void ObjectBuffer::select(std::uint32_t object, const Model::InstanceOffset& offset) {
+	glVertexAttribI1ui(SHCONFIG_IN_OBJECT_LOCATION, object);
+	glVertexAttrib3f(SHCONFIG_IN_OFFSET_LOCATION, offset[0], offset[1], offset[2]);
+}
+
+void ObjectBuffer::deinit() {
+	std::array<std::uint32_t, 2> buffers{{objects_id_, materials_id_}};
+	glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+	objects_id_ = 0;
+	materials_id_ = 0;
+	objects_.clear();
+	materials_.clear();
+	dirty_objects_ = {};
+	dirty_materials_ = {};
+	GlState::invalidate();
+}
@@ -0,0 +1,204 @@
+#include "PagedQuadTree.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <fmt/format.h>
+
+using namespace rw_cube;
+
+PagedQuadTree::PagedQuadTree(
+	std::filesystem::path directory,
+	std::uint8_t page_level,
+	float area_width,
+	float area_height,
+	float area_world_x_pos,
+	float area_world_z_pos,
+	float evict_margin,
+	AssetId asset_count) :
+	directory_(std::move(directory)),
+	page_level_(page_level),
+	area_width_(area_width),
+	area_height_(area_height),
+	area_world_x_pos_(area_world_x_pos),
+	area_world_z_pos_(area_world_z_pos),
+	evict_margin_(evict_margin),
+	asset_count_(asset_count) {
+	if (page_level_ > Page::MAX_TREE_HEIGHT) {
+		throw std::invalid_argument("page level exceeds MAX_TREE_HEIGHT");
+	}
+	loader_ = std::thread([this] { work(); });
+}
+
+PagedQuadTree::~PagedQuadTree() {
+	deinit();
+}
+
+void PagedQuadTree::writePages(
+	const std::filesystem::path& directory,
+	std::uint8_t page_level,
+	std::uint8_t page_height,
+	float area_width,
+	float area_height,
+	float area_world_x_pos,
+	float area_world_z_pos,
+	std::span<const Page::Placement> placements,
+	Page::Storage storage,
+	std::uint32_t bucket_capacity) {
+	const auto page_extent = static_cast<float>(1U << page_level);
+	const auto page_width = area_width / page_extent;
+	const auto page_height_size = area_height / page_extent;
+
+	std::map<std::uint32_t, std::vector<Page::Placement>> page_placements;
+	for (const auto& placement : placements) {
+		const auto x = std::floor((placement.x - area_world_x_pos) / page_width);
+		const auto z = std::floor((placement.z - area_world_z_pos) / page_height_size);
+		if (!(x >= 0.F && z >= 0.F && x < page_extent && z < page_extent)) {
+			continue;
+		}
+		const auto quad_key = Page::encodeQuadKey(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(z));
+		page_placements[static_cast<std::uint32_t>(quad_key)].push_back(placement);
+	}
+
+	std::filesystem::create_directories(directory);
+	for (const auto& [quad_key, page_placement] : page_placements) {
+		const auto [x, z] = Page::decodeQuadKey(quad_key, static_cast<std::uint8_t>(2U * page_level));
+		Page page(
+			page_height, page_width, page_height_size,
+			area_world_x_pos + static_cast<float>(x) * page_width,
+			area_world_z_pos + static_cast<float>(z) * page_height_size,
+			storage, bucket_capacity
+		);
+		page.build(page_placement);
+		page.saveSnapshot(pagePath(directory, page_level, quad_key), [](AssetId asset_id) { return asset_id; });
+	}
+}
+
+void PagedQuadTree::update(float camera_x, float camera_z, float load_distance) {
+	std::vector<LoadedPage> loaded;
+	{
+		const std::lock_guard lock(mutex_);
+		loaded.swap(loaded_);
+	}
+	for (auto& [quad_key, tree] : loaded) {
+		const auto page = pages_.find(quad_key);
+		// pages evicted while being loaded are dropped
+		if (page != pages_.end() && page->second.state == PageState::REQUESTED) {
+			page->second.state = tree != nullptr ? PageState::RESIDENT : PageState::EMPTY;
+			page->second.tree = std::move(tree);
+		}
+	}
+
+	const auto page_extent = static_cast<float>(1U << page_level_);
+	const auto page_width = area_width_ / page_extent;
+	const auto page_height = area_height_ / page_extent;
+	const auto pageCenter = [&](std::uint32_t quad_key) {
+		const auto [x, z] = Page::decodeQuadKey(quad_key, static_cast<std::uint8_t>(2U * page_level_));
+		return std::array<float, 2>{{
+			area_world_x_pos_ + (static_cast<float>(x) + .5F) * page_width,
+			area_world_z_pos_ + (static_cast<float>(z) + .5F) * page_height
+		}};
+	};
+
+	for (auto page = pages_.begin(); page != pages_.end();) {
+		const auto [center_x, center_z] = pageCenter(page->first);
+		if (classifyViewDistance(
+			camera_x, camera_z, load_distance + evict_margin_, center_x, center_z, page_width, page_height
+		) == Containment::OUTSIDE) {
+			page = pages_.erase(page);
+		} else {
+			++page;
+		}
+	}
+
+	// page cells overlapping the square around the load distance
+	const auto cellRange = [&](float camera, float area_pos, float size) {
+		const auto first = std::floor((camera - load_distance - area_pos) / size);
+		const auto last = std::floor((camera + load_distance - area_pos) / size);
+		return std::array<float, 2>{{ std::max(first, 0.F), std::min(last, page_extent - 1.F) }};
+	};
+	const auto [first_x, last_x] = cellRange(camera_x, area_world_x_pos_, page_width);
+	const auto [first_z, last_z] = cellRange(camera_z, area_world_z_pos_, page_height);
+	std::vector<std::uint32_t> requests;
+	for (auto z{first_z}; z <= last_z; ++z) {
+		for (auto x{first_x}; x <= last_x; ++x) {
+			const auto quad_key = static_cast<std::uint32_t>(
+				Page::encodeQuadKey(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(z))
+			);
+			if (pages_.contains(quad_key)) {
+				continue;
+			}
+			const auto [center_x, center_z] = pageCenter(quad_key);
+			if (classifyViewDistance(
+				camera_x, camera_z, load_distance, center_x, center_z, page_width, page_height
+			) != Containment::OUTSIDE) {
+				pages_.emplace(quad_key, PageSlot{ .state = PageState::REQUESTED, .tree = nullptr });
+				requests.push_back(quad_key);
+			}
+		}
+	}
+	if (!requests.empty()) {
+		{
+			const std::lock_guard lock(mutex_);
+			requests_.insert(requests_.end(), requests.begin(), requests.end());
+		}
+		requests_cv_.notify_one();
+	}
+}
+
+std::size_t PagedQuadTree::residentPageCount() const {
+	std::size_t count{ 0 };
+	for (const auto& [quad_key, page] : pages_) {
+		count += page.tree != nullptr ? 1U : 0U;
+	}
+	return count;
+}
+
+void PagedQuadTree::deinit() {
+	{
+		const std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	requests_cv_.notify_one();
+	if (loader_.joinable()) {
+		loader_.join();
+	}
+	pages_.clear();
+}
+
+std::filesystem::path PagedQuadTree::pagePath(
+	const std::filesystem::path& directory, std::uint8_t page_level, std::uint32_t quad_key) {
+	return directory / fmt::format("page_{}_{}.rwqt", page_level, quad_key);
+}
+
+void PagedQuadTree::work() {
+	while (true) {
+		std::uint32_t quad_key{ 0 };
+		{
+			std::unique_lock lock(mutex_);
+			requests_cv_.wait(lock, [this] { return stop_ || !requests_.empty(); });
+			if (stop_) {
+				return;
+			}
+			quad_key = requests_.front();
+			requests_.pop_front();
+		}
+
+		std::shared_ptr<const Page> tree;
+		const auto path = pagePath(directory_, page_level_, quad_key);
+		if (std::filesystem::exists(path)) {
+			try {
+				auto page = std::make_shared<Page>(Page::mapSnapshot(path, asset_count_));
+				page->mapped_file_->prefault();
+				tree = std::move(page);
+			} catch (const std::exception&) {
+				// unreadable page is treated as empty
+				tree = nullptr;
+			}
+		}
+
+		const std::lock_guard lock(mutex_);
+		loaded_.push_back(LoadedPage{ quad_key, std::move(tree) });
+	}
+}
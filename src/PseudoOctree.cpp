@@ -0,0 +1,18 @@
+#include "Frustum.hpp"
+#include "PseudoQuadTree.hpp"
+
+// the demo traverses quad trees only, octree specializations are instantiated here so that
+// the octree paths of the tree and of its frustum culling keep compiling
+namespace rw_cube {
+
+using OctreeLeafAction = void (*)(const PseudoOctree<AssetId>::Leaf&);
+
+template struct PseudoQuadTree<AssetId, DYNAMIC_TREE_HEIGHT, OCTREE_DIMENSIONS>;
+template struct QuadTreeFrustumCulling<AssetId, DYNAMIC_TREE_HEIGHT, OCTREE_DIMENSIONS>;
+
+template void PseudoOctree<AssetId>::depthFirstTraversal(
+    OctreeLeafAction&& value_action, PseudoOctree<AssetId>::AcceptAll&& predicate) const;
+template void QuadTreeFrustumCulling<AssetId, DYNAMIC_TREE_HEIGHT, OCTREE_DIMENSIONS>::depthFirstTraversal(
+    const PseudoOctree<AssetId>& tree, OctreeLeafAction&& value_action, PseudoOctree<AssetId>::AcceptAll&& predicate) const;
+
+}
@@ -0,0 +1,115 @@
+#include "RenderQueue.hpp"
+#include "GlState.hpp"
+#include "ObjectBuffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include <glad/glad.h>
+
+using namespace rw_cube;
+
+static_assert(
+	RenderQueue::PASS_BITS + RenderQueue::PROGRAM_BITS + RenderQueue::VAO_BITS +
+	RenderQueue::TEXTURE_BITS + RenderQueue::DEPTH_BITS == 64U,
+	"sort key fields have to fill 64 bits"
+);
+
+namespace {
+
+constexpr std::uint64_t field(std::uint64_t value, std::uint32_t bits) {
+	return value & ((std::uint64_t{ 1 } << bits) - 1U);
+}
+
+constexpr std::uint32_t NOTHING_BOUND{ std::numeric_limits<std::uint32_t>::max() };
+
+}
+
+std::uint64_t RenderQueue::sortKey(
+	std::uint32_t pass, std::uint32_t program_id, std::uint32_t vao_id, std::uint32_t texture_id, float depth) {
+	static constexpr auto max_depth = static_cast<float>((std::uint32_t{ 1 } << DEPTH_BITS) - 1U);
+	const auto quantized_depth = static_cast<std::uint64_t>(std::clamp(depth, 0.F, 1.F) * max_depth);
+	std::uint64_t key{ field(pass, PASS_BITS) };
+	key = (key << PROGRAM_BITS) | field(program_id, PROGRAM_BITS);
+	key = (key << VAO_BITS) | field(vao_id, VAO_BITS);
+	key = (key << TEXTURE_BITS) | field(texture_id, TEXTURE_BITS);
+	return (key << DEPTH_BITS) | field(quantized_depth, DEPTH_BITS);
+}
+
+void RenderQueue::clear() {
+	packets_.clear();
+}
+
+void RenderQueue::push(const DrawPacket& packet) {
+	packets_.push_back(packet);
+}
+
+// least significant digit first, 8 bit digits; a pass is skipped when all keys share its digit
+void RenderQueue::sort() {
+	entries_.resize(packets_.size());
+	for (std::size_t i{0}; i<packets_.size(); ++i) {
+		entries_[i] = SortEntry{ .key = packets_[i].key, .packet = static_cast<std::uint32_t>(i) };
+	}
+	if (entries_.size() < 2U) {
+		return;
+	}
+	sort_scratch_.resize(entries_.size());
+	static constexpr std::uint32_t digit_bits{ 8U };
+	static constexpr std::size_t digit_count{ std::size_t{ 1 } << digit_bits };
+	for (std::uint32_t shift{0}; shift<64U; shift += digit_bits) {
+		std::array<std::uint32_t, digit_count> offsets{};
+		for (const auto& entry : entries_) {
+			++offsets[(entry.key >> shift) & (digit_count - 1U)];
+		}
+		if (offsets[(entries_.front().key >> shift) & (digit_count - 1U)] == entries_.size()) {
+			continue;
+		}
+		std::uint32_t offset{ 0 };
+		for (auto& digit_offset : offsets) {
+			const auto count = digit_offset;
+			digit_offset = offset;
+			offset += count;
+		}
+		for (const auto& entry : entries_) {
+			sort_scratch_[offsets[(entry.key >> shift) & (digit_count - 1U)]++] = entry;
+		}
+		entries_.swap(sort_scratch_);
+	}
+}
+
+void RenderQueue::submit() {
+	sort();
+	stats_ = {};
+	// state other code left bound is unknown
+	std::uint32_t program_id{ NOTHING_BOUND };
+	std::uint32_t vao_id{ NOTHING_BOUND };
+	std::uint32_t texture_id{ NOTHING_BOUND };
+	std::uint32_t texture_unit{ NOTHING_BOUND };
+	for (const auto& entry : entries_) {
+		const auto& packet = packets_[entry.packet];
+		if (packet.program_id != program_id) {
+			program_id = packet.program_id;
+			GlState::useProgram(program_id);
+			++stats_.program_binds;
+		}
+		if (packet.vao_id != vao_id) {
+			vao_id = packet.vao_id;
+			GlState::bindVertexArray(vao_id);
+			++stats_.vao_binds;
+		}
+		if (packet.texture_id != texture_id || packet.texture_unit != texture_unit) {
+			texture_id = packet.texture_id;
+			texture_unit = packet.texture_unit;
+			GlState::bindTextureUnit(texture_unit, texture_id);
+			++stats_.texture_binds;
+		}
+		ObjectBuffer::select(packet.object, packet.offset);
+		if (packet.indexed) {
+			glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(packet.count), GL_UNSIGNED_INT, nullptr);
+		} else {
+			glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(packet.count));
+		}
+		++stats_.draws;
+	}
+}
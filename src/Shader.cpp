@@ -1,4 +1,5 @@
 #include "Shader.hpp"
+#include "GlState.hpp"
 
 #include <exception>
 #include <fstream>
@@ -69,7 +70,7 @@ void Shader::compileShader(const std::filesystem::path &path, std::uint32_t shad
 	glCompileShader(shader_id);
 }
 void Shader::bind() const {
-	glUseProgram(prog_id_);
+	GlState::useProgram(prog_id_);
 }
 
 void Shader::deinit() {
@@ -81,4 +82,41 @@ void Shader::deinit() {
 	}
 	glDeleteProgram(prog_id_);
 	prog_id_ = 0;
-}
\ No newline at end of file
+	GlState::invalidate();
+}
+
+ComputeShader::ComputeShader(bool is_spirv, const std::filesystem::path& path) {
+	prog_id_ = glCreateProgram();
+	shader_id_ = glCreateShader(GL_COMPUTE_SHADER);
+
+	if (is_spirv) {
+		const auto sh_binary = Shader::parseAsSpirv(path);
+		glShaderBinary(1, static_cast<const GLuint *>(&shader_id_),
+					GL_SHADER_BINARY_FORMAT_SPIR_V_ARB,
+					static_cast<const void *>(sh_binary.data()),
+					static_cast<GLsizei>(sh_binary.size()));
+		glSpecializeShaderARB(shader_id_, "main", 0, nullptr, nullptr);
+	} else {
+		Shader::compileShader(path, shader_id_);
+	}
+	glAttachShader(prog_id_, shader_id_);
+	glLinkProgram(prog_id_);
+}
+
+void ComputeShader::bind() const {
+	GlState::useProgram(prog_id_);
+}
+
+void ComputeShader::dispatch(std::uint32_t group_count_x) const {
+	bind();
+	glDispatchCompute(group_count_x, 1, 1);
+}
+
+void ComputeShader::deinit() {
+	glDetachShader(prog_id_, shader_id_);
+	glDeleteShader(shader_id_);
+	shader_id_ = 0;
+	glDeleteProgram(prog_id_);
+	prog_id_ = 0;
+	GlState::invalidate();
+}
@@ -0,0 +1,102 @@
+#include "StreamBuffer.hpp"
+#include "GlState.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+using namespace rw_cube;
+
+namespace {
+
+constexpr std::size_t alignUp(std::size_t value, std::size_t alignment) {
+	return (value + alignment - 1U) / alignment * alignment;
+}
+
+}
+
+StreamBuffer::StreamBuffer(std::uint32_t target, std::size_t region_size, std::uint32_t region_count) :
+	target_(target),
+	region_count_(region_count),
+	offset_alignment_(offsetAlignment(target)),
+	fences_(region_count, nullptr),
+	region_(region_count - 1U) {
+	if (region_count_ == 0U) {
+		throw std::invalid_argument("stream buffer needs at least one region");
+	}
+	// every region starts at an aligned offset
+	region_size_ = alignUp(region_size, offset_alignment_);
+	const auto size = static_cast<GLsizeiptr>(region_size_ * region_count_);
+	static constexpr GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+	glCreateBuffers(1, &buffer_id_);
+	glNamedBufferStorage(buffer_id_, size, nullptr, flags);
+	mapped_ = static_cast<std::byte*>(glMapNamedBufferRange(buffer_id_, 0, size, flags));
+	if (mapped_ == nullptr) {
+		throw std::runtime_error("failed to map stream buffer");
+	}
+}
+
+std::size_t StreamBuffer::offsetAlignment(std::uint32_t target) {
+	GLint alignment{ 1 };
+	glGetIntegerv(
+		target == GL_SHADER_STORAGE_BUFFER ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+		&alignment
+	);
+	return alignment > 0 ? static_cast<std::size_t>(alignment) : 1U;
+}
+
+void StreamBuffer::beginFrame() {
+	region_ = (region_ + 1U) % region_count_;
+	region_offset_ = 0U;
+	auto& fence = fences_[region_];
+	if (fence == nullptr) {
+		return;
+	}
+	static constexpr GLuint64 wait_timeout_ns{ 1'000'000U };
+	auto* sync = static_cast<GLsync>(fence);
+	auto status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0U);
+	while (status == GL_TIMEOUT_EXPIRED) {
+		status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, wait_timeout_ns);
+	}
+	glDeleteSync(sync);
+	fence = nullptr;
+}
+
+std::size_t StreamBuffer::push(const void* data, std::size_t size) {
+	if (region_offset_ + size > region_size_) {
+		throw std::length_error("stream buffer region is full");
+	}
+	const auto offset = region_ * region_size_ + region_offset_;
+	std::memcpy(mapped_ + offset, data, size); // NOLINT
+	region_offset_ = alignUp(region_offset_ + size, offset_alignment_);
+	return offset;
+}
+
+void StreamBuffer::bindRange(std::uint32_t binding, std::size_t offset, std::size_t size) const {
+	GlState::bindBufferRange(target_, binding, buffer_id_, offset, size);
+}
+
+void StreamBuffer::endFrame() {
+	auto& fence = fences_[region_];
+	if (fence != nullptr) {
+		glDeleteSync(static_cast<GLsync>(fence));
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::deinit() {
+	for (auto& fence : fences_) {
+		if (fence != nullptr) {
+			glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+	}
+	if (mapped_ != nullptr) {
+		glUnmapNamedBuffer(buffer_id_);
+		mapped_ = nullptr;
+	}
+	glDeleteBuffers(1, &buffer_id_);
+	buffer_id_ = 0;
+	GlState::invalidate();
+}
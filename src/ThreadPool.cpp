@@ -0,0 +1,74 @@
+#include "ThreadPool.hpp"
+
+using namespace rw_cube;
+
+ThreadPool::ThreadPool(std::size_t worker_count) {
+	workers_.reserve(worker_count);
+	for (std::size_t i{0}; i<worker_count; ++i) {
+		workers_.emplace_back([this, i] { work(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	deinit();
+}
+
+std::size_t ThreadPool::threadCount() const {
+	return workers_.size() + 1U;
+}
+
+void ThreadPool::run(std::size_t task_count, const Task& task) {
+	{
+		const std::lock_guard lock(mutex_);
+		task_ = &task;
+		task_count_ = task_count;
+		next_task_.store(0U, std::memory_order_relaxed);
+		busy_workers_ = workers_.size();
+		++generation_;
+	}
+	start_cv_.notify_all();
+	runTasks(workers_.size());
+
+	std::unique_lock lock(mutex_);
+	done_cv_.wait(lock, [this] { return busy_workers_ == 0U; });
+	task_ = nullptr;
+}
+
+void ThreadPool::deinit() {
+	{
+		const std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+	start_cv_.notify_all();
+	for (auto& worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+void ThreadPool::work(std::size_t thread_index) {
+	std::size_t seen_generation{ 0 };
+	while (true) {
+		{
+			std::unique_lock lock(mutex_);
+			start_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+			if (stop_) {
+				return;
+			}
+			seen_generation = generation_;
+		}
+		runTasks(thread_index);
+		{
+			const std::lock_guard lock(mutex_);
+			if (--busy_workers_ == 0U) {
+				done_cv_.notify_one();
+			}
+		}
+	}
+}
+
+void ThreadPool::runTasks(std::size_t thread_index) {
+	for (auto i = next_task_.fetch_add(1U); i < task_count_; i = next_task_.fetch_add(1U)) {
+		(*task_)(i, thread_index);
+	}
+}
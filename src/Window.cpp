@@ -1,4 +1,5 @@
 #include "Window.hpp"
+#include "GlState.hpp"
 
 #include <stdexcept>
 
@@ -70,7 +71,7 @@ std::pair<int, int> Window::size() const {
 	return {w, h};
 }
 void Window::setViewport(int w, int h) const {
-	glViewport(0, 0, w, h);
+	GlState::viewport(0, 0, w, h);
 }
 void Window::setWinUserDataPointer(void* ptr){
 	glfwSetWindowUserPointer(win_handle_->value, ptr);
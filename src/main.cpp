@@ -1,14 +1,34 @@
 #include <Cube.hpp>
 #include <Shader.hpp>
-#include <Ubo.hpp>
+#include <GlState.hpp>
+#include <ObjectBuffer.hpp>
+#include <StreamBuffer.hpp>
 #include <Window.hpp>
 #include <Camera.hpp>
 #include <Model.hpp>
 #include <PseudoQuadTree.hpp>
+#include <Frustum.hpp>
+#include <ThreadPool.hpp>
+#include <ParallelQuadTreeTraversal.hpp>
+#include <RenderQueue.hpp>
+#include <PagedQuadTree.hpp>
+#include <LooseQuadTree.hpp>
+#include <CachedQuadTreeTraversal.hpp>
+#include <ConcurrentQuadTree.hpp>
+#include <GpuCulling.hpp>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string_view>
 #include <numbers>
+#include <thread>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 #include <glad/glad.h>
@@ -26,11 +46,19 @@ struct WinData {
 	bool light_move_mode{ false };
 	float* light_pos;
 	float view_distance{ 20.F };
+	bool instanced_mode{ true };
+	bool frustum_culling{ true };
+	bool parallel_culling{ true };
+	bool paged_mode{ false };
+	bool loose_culling{ false };
+	bool cached_culling{ false };
+	bool simulated_mode{ false };
+	bool gpu_culling{ false };
 };
 
-struct UboData {
+// contents of the Frame uniform block, per object data lives in ObjectBuffer
+struct FrameData {
     mat4x4 vp;
-    mat4x4 m_position;
     vec3 light_pos;
     float ambient_light;
 	alignas(16) vec3 camera_pos;
@@ -53,8 +81,8 @@ int main() {
 		};
 
 		Camera camera;
-		UboData ubo_data{ .light_pos = {3.5F, 0.F, 5.F}, .ambient_light = 0.2F};
-		WinData win_data = { .camera = camera, .light_pos = ubo_data.light_pos};
+		FrameData frame_data{ .vp = {}, .light_pos = {3.5F, 0.F, 5.F}, .ambient_light = 0.2F, .camera_pos = {} };
+		WinData win_data = { .camera = camera, .light_pos = frame_data.light_pos};
 		win.setWinUserDataPointer(static_cast<void*>(&win_data));
 		win.setKeyCallback(+[](GLFWwindow* win_handle, int key, int, int action, int) {
 			if (action == GLFW_PRESS or action == GLFW_REPEAT) {
@@ -109,6 +137,46 @@ int main() {
 				case GLFW_KEY_L:
 						win_data_ptr->light_move_mode = !win_data_ptr->light_move_mode;
 					break;
+				case GLFW_KEY_I:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->instanced_mode = !win_data_ptr->instanced_mode;
+						}
+					break;
+				case GLFW_KEY_F:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->frustum_culling = !win_data_ptr->frustum_culling;
+						}
+					break;
+				case GLFW_KEY_M:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->parallel_culling = !win_data_ptr->parallel_culling;
+						}
+					break;
+				case GLFW_KEY_G:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->paged_mode = !win_data_ptr->paged_mode;
+						}
+					break;
+				case GLFW_KEY_B:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->loose_culling = !win_data_ptr->loose_culling;
+						}
+					break;
+				case GLFW_KEY_N:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->cached_culling = !win_data_ptr->cached_culling;
+						}
+					break;
+				case GLFW_KEY_V:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->simulated_mode = !win_data_ptr->simulated_mode;
+						}
+					break;
+				case GLFW_KEY_U:
+						if (action == GLFW_PRESS) {
+							win_data_ptr->gpu_culling = !win_data_ptr->gpu_culling;
+						}
+					break;
 				case GLFW_KEY_Q: glfwSetWindowShouldClose(win_handle, GLFW_TRUE); break;
 				case GLFW_KEY_P: win_data_ptr->view_distance += 1.2F; break;
 				case GLFW_KEY_O: win_data_ptr->view_distance -= 
@@ -186,64 +254,230 @@ int main() {
 
 		Model gun_model(is_arb_spirv_supported, "assets/models/gun_d.obj", "assets/textures/rust_texture.png");
 
-		UBO ubo(SHCONFIG_MVP_UBO_BINDING, sizeof(UboData) + sizeof(Model::Material)); // NOLINT
-		ubo.sendData(
-			static_cast<const void*>(&gun_model.model_material_),
-			sizeof(UboData),
-			sizeof(Model::Material)	
-		);
-
-		using PseudoQuadTreeType = PseudoQuadTree<Model*>;
+		static constexpr std::uint8_t QUAD_TREE_HEIGHT{ 4U };
+		using PseudoQuadTreeType = PseudoQuadTree<AssetId, QUAD_TREE_HEIGHT>;
 
-		PseudoQuadTreeType quad_tree(4U, 100.F, 100.F, 0.F, 8.F);
-		quad_tree.addToRandomLeaves(&gun_model, 1000U);
+		// leaves hold indices into assets
+		static constexpr AssetId GUN_ASSET_ID{ 0U };
+		const std::array<Model*, 1> assets{{ &gun_model }};
 
-		const auto tree_value_action = [&ubo, &ubo_data](const PseudoQuadTreeType::Leaf& leaf) {
+		// nothing in the scene moves so objects are uploaded once and each frame writes only FrameData,
+		// instanced draws and tree leaves use the object of their asset with the leaf position as offset
+		ObjectBuffer object_buffer(
+			static_cast<std::uint32_t>(cube.cube_count + 1U + assets.size()), 
+			static_cast<std::uint32_t>(1U + assets.size())
+		);
+		const auto cube_material = object_buffer.addMaterial({});
+		for (auto* model : assets) {
+			mat4x4 identity;
+			mat4x4_identity(identity);
+			model->object_id_ = object_buffer.addObject(identity, object_buffer.addMaterial(model->model_material_));
+		}
+		std::vector<std::uint32_t> cube_objects;
+		for (std::size_t i{0}; i<cube.cube_count; ++i) {
+			const auto offset = cube.offsets[i];
 			mat4x4 model_mat;
-			mat4x4_translate(model_mat, leaf.x, 0.F, leaf.z);				
-			mat4x4_dup(ubo_data.m_position, model_mat);
-			ubo.sendData(
-				static_cast<const void *>(&ubo_data.m_position), 
-				offsetof(UboData, m_position), 
-				sizeof(UboData::m_position)
+			mat4x4_translate(model_mat, offset[0], offset[1], 7.F + offset[2]);
+			mat4x4_translate_in_place(model_mat, -.5F, -.5F, -.5F);
+			cube_objects.push_back(object_buffer.addObject(model_mat, cube_material));
+		}
+		const auto gun_object = [&] {
+			mat4x4 model_mat;
+			mat4x4_translate(model_mat, 2.F, 1.F, 5.F);
+			return object_buffer.addObject(model_mat, object_buffer.objects_[gun_model.object_id_].material);
+		}();
+
+		// placements are generated once, later runs map the saved snapshot
+		static constexpr std::string_view QUAD_TREE_SNAPSHOT_PATH{ "quad_tree.rwqt" };
+		const auto asset_count = static_cast<AssetId>(assets.size());
+		bool placements_regenerated{ false };
+		auto quad_tree = [asset_count, &placements_regenerated] {
+			if (std::filesystem::exists(QUAD_TREE_SNAPSHOT_PATH)) {
+				try {
+					return PseudoQuadTreeType::mapSnapshot(QUAD_TREE_SNAPSHOT_PATH, asset_count);
+				} catch (const std::runtime_error& e) {
+					spdlog::warn("{}, placements are regenerated", e.what());
+				}
+			}
+			PseudoQuadTreeType tree(100.F, 100.F, 0.F, 8.F);
+			tree.addToRandomLeaves(GUN_ASSET_ID, 1000U);
+			placements_regenerated = true;
+			try {
+				tree.saveSnapshot(QUAD_TREE_SNAPSHOT_PATH, [](AssetId asset_id) { return asset_id; });
+			} catch (const std::exception& e) {
+				spdlog::warn("{}, placements are kept in memory only", e.what());
+			}
+			return tree;
+		}();
+
+		// same placements split into 4^2 pages streamed around the camera,
+		// rewritten with the snapshot so that both hold the same placements
+		static constexpr std::string_view QUAD_TREE_PAGES_PATH{ "quad_tree_pages" };
+		static constexpr std::uint8_t PAGE_LEVEL{ 2U };
+		if (placements_regenerated || !std::filesystem::exists(QUAD_TREE_PAGES_PATH)) {
+			std::filesystem::remove_all(QUAD_TREE_PAGES_PATH);
+			std::vector<PagedQuadTree::Page::Placement> placements;
+			quad_tree.depthFirstTraversal([&placements](const PseudoQuadTreeType::Leaf& leaf) {
+				placements.push_back({ .x = leaf.x, .z = leaf.z, .value = leaf.value });
+			});
+			PagedQuadTree::writePages(
+				QUAD_TREE_PAGES_PATH, PAGE_LEVEL, QUAD_TREE_HEIGHT - PAGE_LEVEL, 
+				100.F, 100.F, 0.F, 8.F, placements
 			);
-			leaf.value->draw();
-		};
-
-		const auto tree_traversal_predicate = [&camera, &win_data](const PseudoQuadTreeType::Iterator::ValueType& value) {
-			const auto camera_x = camera.position_[0];
-			const auto camera_z = camera.position_[2];
+		}
+		PagedQuadTree paged_tree(QUAD_TREE_PAGES_PATH, PAGE_LEVEL, 100.F, 100.F, 0.F, 8.F, 10.F, asset_count);
+
+		// same leaves indexed by the bounds of their model so culling sees the whole mesh
+		using LooseQuadTreeType = LooseQuadTree<PseudoQuadTreeType::Leaf>;
+		LooseQuadTreeType loose_tree(QUAD_TREE_HEIGHT, 100.F, 100.F, 0.F, 8.F);
+		{
+			std::vector<LooseQuadTreeType::Placement> placements;
+			quad_tree.depthFirstTraversal([&placements, &assets](const PseudoQuadTreeType::Leaf& leaf) {
+				const auto* model = assets[leaf.value];
+				placements.push_back({
+					.bounds = {
+						.min = {{ leaf.x + model->bounds_min_[0], model->bounds_min_[1], leaf.z + model->bounds_min_[2] }},
+						.max = {{ leaf.x + model->bounds_max_[0], model->bounds_max_[1], leaf.z + model->bounds_max_[2] }}
+					},
+					.value = leaf
+				});
+			});
+			loose_tree.build(placements);
+		}
 
-			const auto half_area_width = value.area_width/2.F;
-			const auto half_area_height = value.area_height/2.F;
+		// same leaves culled by a compute shader and drawn indirectly
+		GpuCulling gpu_culling = [&] {
+			std::vector<GpuCulling::Object> objects;
+			quad_tree.depthFirstTraversal([&objects](const PseudoQuadTreeType::Leaf& leaf) {
+				objects.push_back({ .position = {{ leaf.x, 0.F, leaf.z }}, .mesh = leaf.value });
+			});
+			return GpuCulling(is_arb_spirv_supported, assets, objects);
+		}();
+
+		// culling split into the 4^3 subtrees below the root
+		ThreadPool thread_pool(std::max(std::thread::hardware_concurrency(), 1U) - 1U);
+		ParallelQuadTreeTraversal<AssetId, QUAD_TREE_HEIGHT> parallel_traversal(thread_pool, 3U);
+
+		// copy of the tree whose first guns are moved by a simulation thread while this thread culls it
+		ConcurrentQuadTree<AssetId, QUAD_TREE_HEIGHT> concurrent_tree(quad_tree, 1U);
+		static constexpr std::size_t RENDER_READER{ 0U };
+		std::atomic<bool> simulation_running{ false };
+		std::jthread simulation([&concurrent_tree, &simulation_running, &quad_tree](const std::stop_token& stop_token) {
+			static constexpr std::size_t SIMULATED_COUNT{ 64U };
+			static constexpr float RADIUS{ 2.F };
+			static constexpr auto TICK{ std::chrono::milliseconds(16) };
+			struct Simulated {
+				std::array<float, 2> center;
+				PseudoQuadTreeType::Position position;
+				AssetId value;
+			};
+			std::vector<Simulated> simulated;
+			quad_tree.depthFirstTraversal([&simulated](const PseudoQuadTreeType::Leaf& leaf) {
+				if (simulated.size() < SIMULATED_COUNT) {
+					simulated.push_back({ .center = {{ leaf.x, leaf.z }}, .position = {{ leaf.x, leaf.z }}, .value = leaf.value });
+				}
+			});
+			const auto start = std::chrono::steady_clock::now();
+			while (!stop_token.stop_requested()) {
+				std::this_thread::sleep_for(TICK);
+				if (!simulation_running.load(std::memory_order_relaxed)) {
+					continue;
+				}
+				const auto time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+				for (std::size_t i{0}; i<simulated.size(); ++i) {
+					auto& object = simulated[i];
+					const auto angle = time + static_cast<float>(i);
+					const PseudoQuadTreeType::Position position{{ 
+						object.center[0] + RADIUS * std::cos(angle), object.center[1] + RADIUS * std::sin(angle) 
+					}};
+					if (concurrent_tree.move(object.position, object.value, position)) {
+						object.position = position;
+					}
+				}
+				concurrent_tree.publish();
+			}
+		});
 
-			const auto area_x0 = value.node.x - half_area_width;
-			const auto area_z0 = value.node.z - half_area_height;
+		// visible leaves gathered per asset, drawn with one instanced call per model
+		GroupedLeafBuffer<Model::InstanceOffset> instance_batch;
+		const auto instance_group = [](const PseudoQuadTreeType::Leaf& leaf) -> std::size_t {
+			return leaf.value;
+		};
+		const auto instance_offset = [](const PseudoQuadTreeType::Leaf& leaf) {
+			return Model::InstanceOffset{leaf.x, 0.F, leaf.z};
+		};
 
-			const auto area_x1 = value.node.x + half_area_width;
-			const auto area_z1 = value.node.z + half_area_height;
+		// FrameData of the frames in flight
+		StreamBuffer frame_stream(GL_UNIFORM_BUFFER, sizeof(FrameData));
+
+		// single draws of a frame sorted by state, nearer ones first within the same state
+		RenderQueue render_queue;
+		static constexpr std::uint32_t OPAQUE_PASS{ 0U };
+		const auto queue_draw = [&render_queue, &camera](DrawPacket packet, const Model::InstanceOffset& position) {
+			vec3 to_position;
+			vec3_sub(to_position, position.data(), camera.position_);
+			packet.key = RenderQueue::sortKey(
+				OPAQUE_PASS, packet.program_id, packet.vao_id, packet.texture_id, vec3_len(to_position) / 100.F
+			);
+			render_queue.push(packet);
+		};
+		const auto queue_model = [&queue_draw](
+			const Model& model, std::uint32_t object, const Model::InstanceOffset& offset, const Model::InstanceOffset& position) {
+			queue_draw({
+				.key = 0U,
+				.program_id = model.model_shader_.prog_id_,
+				.vao_id = model.vao_id_,
+				.texture_id = model.tex_id_,
+				.texture_unit = SHCONFIG_2D_MODEL_TEX_BINDING,
+				.count = model.indices_count_,
+				.indexed = true,
+				.object = object,
+				.offset = offset
+			}, position);
+		};
 
-			if (camera_x >= area_x0 && camera_x < area_x1 &&
-				camera_z >= area_z0 && camera_z < area_z1) {
-				return true;
+		const auto tree_value_action = [&win_data, &instance_batch, &assets, &queue_model](const auto& leaf) {
+			const Model::InstanceOffset position{leaf.x, 0.F, leaf.z};
+			if (win_data.instanced_mode) {
+				instance_batch.append(leaf.value, position);
+				return;
 			}
+			const auto* model = assets[leaf.value];
+			queue_model(*model, model->object_id_, position, position);
+		};
 
-			const float dx = std::min(
-				std::abs(camera_x - area_x0), 
-				std::abs(camera_x - area_x1)
-			);
-			const float dz = std::min(
-				std::abs(camera_z - area_z0), 
-				std::abs(camera_z - area_z1)
+		const auto tree_traversal_predicate = [&camera, &win_data](const auto& value) {
+			return classifyViewDistance(
+				camera.position_[0], camera.position_[2], win_data.view_distance,
+				value.x, value.z, value.area_width, value.area_height
 			);
+		};
 
-			return std::max(dx, dz) < win_data.view_distance;
+		// visible set kept between frames, instances stay in the model buffers and
+		// only slots of leaves entering or leaving the set are rewritten
+		using CachedTraversalType = CachedQuadTreeTraversal<AssetId, QUAD_TREE_HEIGHT>;
+		CachedTraversalType cached_traversal(quad_tree);
+		struct CachedInstances {
+			std::vector<Model::InstanceOffset> offsets;
+			std::vector<CachedTraversalType::LeafIndex> leaves;
+			// slots [dirty_first, dirty_last) differ from the instance buffer
+			std::size_t dirty_first{ std::numeric_limits<std::size_t>::max() };
+			std::size_t dirty_last{ 0 };
+
+			void markDirty(std::size_t first, std::size_t last) {
+				dirty_first = std::min(dirty_first, first);
+				dirty_last = std::max(dirty_last, last);
+			}
 		};
-		PseudoQuadTreeType::Iterator quad_tree_iter(
-			quad_tree, 
-			tree_value_action,
-			tree_traversal_predicate
-		);
+		std::unordered_map<Model*, CachedInstances> cached_instances;
+		// slot of a leaf in the instances of its model
+		std::vector<std::uint32_t> cached_slots(quad_tree.leaves().size());
+		bool cached_last_frame{ false };
+		std::array<float, 4> cached_parameters{};
+		std::array<float, 3> cached_camera_position{};
+		std::array<std::array<float, 3>, 3> cached_camera_axes{};
+		// how far a camera rotation moves points is measured at the far plane
+		static constexpr float CACHED_ROTATION_REACH{ 100.F };
 
 
 		float last_time{0.F};
@@ -264,9 +498,15 @@ int main() {
 			mat4x4 vp;
 			mat4x4_mul(vp, proj_mat, view_mat);
 
-			// ubo data update camera position + vp
-			vec3_dup(ubo_data.camera_pos, camera.position_);
-			mat4x4_dup(ubo_data.vp, vp);
+			frame_stream.beginFrame();
+
+			// frame data update camera position + vp
+			vec3_dup(frame_data.camera_pos, camera.position_);
+			mat4x4_dup(frame_data.vp, vp);
+			frame_stream.bindRange(
+				SHCONFIG_FRAME_UBO_BINDING, frame_stream.push(&frame_data, sizeof(FrameData)), sizeof(FrameData)
+			);
+			object_buffer.upload();
 
 			const auto time = win.time();
 			const float timestep = time - last_time;
@@ -285,43 +525,213 @@ int main() {
 			const auto [x_pos, y_pos, z_pos] = cube.move(x_mv, y_mv, z_mv);
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			cube.bind();
+			render_queue.clear();
 			for (std::size_t i{0}; i<cube.cube_count; ++i) {
-				const auto shader = cube.shaders[i];
 				const auto offset = cube.offsets[i];
-
-				mat4x4 model_mat;
-				mat4x4_translate(model_mat, 
-					0.F /*+ x_pos*/ + offset[0], 
-					0.F /*+ y_pos*/ + offset[1], 
-					7.F /*+ z_pos*/ + offset[2]
-				);				
-				// mat4x4_rotate_X(model_mat, model_mat, x_angle);
-				// mat4x4_rotate_Y(model_mat, model_mat, y_angle);
-				// mat4x4_rotate_Z(model_mat, model_mat, z_angle);
-				mat4x4_translate_in_place(model_mat, -.5F, -.5F, -.5F);
-
-				// ubo data update model mat
-				mat4x4_dup(ubo_data.m_position, model_mat);
-
-				ubo.sendData(static_cast<const void *>(&ubo_data), 0, sizeof(UboData));
 				// NOLINTEND
-				shader.bind();
-				cube.draw();
+				queue_draw({
+					.key = 0U,
+					.program_id = cube.shaders[i].prog_id_,
+					.vao_id = cube.vao_id_,
+					.texture_id = cube.tex_id_,
+					.texture_unit = SHCONFIG_2D_TEX_ARRAY_BINDING,
+					.count = static_cast<std::uint32_t>(Cube::INDICES.size()),
+					.indexed = false,
+					.object = cube_objects[i],
+					.offset = {}
+				}, {offset[0], offset[1], 7.F + offset[2]});
 			}
-			mat4x4 model_mat;
-			mat4x4_translate(model_mat, 2.F, 1.F, 5.F);				
-			mat4x4_dup(ubo_data.m_position, model_mat);
-			ubo.sendData(static_cast<const void *>(&ubo_data), 0, sizeof(UboData));
-			gun_model.bind();
-			gun_model.draw();
-			quad_tree_iter.depthFirstTraversal();
+			queue_model(gun_model, gun_object, {}, {2.F, 1.F, 5.F});
+			instance_batch.reset(assets.size());
+			const Frustum frustum(vp);
+			// bounds of the gun model around its origin
+			const QuadTreeFrustumCulling<AssetId, QUAD_TREE_HEIGHT> frustum_culling{
+				.frustum_ = frustum, .y_min_ = -.5F, .y_max_ = 1.5F, .leaf_extent_ = 3.5F
+			};
+			bool cached_this_frame{ false };
+			simulation_running.store(win_data.simulated_mode, std::memory_order_relaxed);
+			if (win_data.paged_mode) {
+				paged_tree.update(camera.position_[0], camera.position_[2], win_data.view_distance);
+				const QuadTreeFrustumCulling<AssetId> page_frustum_culling{
+					.frustum_ = frustum, .y_min_ = -.5F, .y_max_ = 1.5F, .leaf_extent_ = 3.5F
+				};
+				paged_tree.forEachResidentPage([&](const PagedQuadTree::Page& page) {
+					if (win_data.frustum_culling) {
+						page_frustum_culling.depthFirstTraversal(page, tree_value_action, tree_traversal_predicate);
+					} else {
+						page.depthFirstTraversal(tree_value_action, tree_traversal_predicate);
+					}
+				});
+			} else if (win_data.loose_culling) {
+				const LooseQuadTreeFrustumCulling loose_frustum_culling{ .frustum_ = frustum };
+				loose_tree.depthFirstTraversal(
+					[&](const LooseQuadTreeType::Leaf& leaf) {
+						tree_value_action(leaf.value.value);
+					},
+					[&](const LooseQuadTreeType::TraversalValue& value) {
+						const auto containment = tree_traversal_predicate(value);
+						return win_data.frustum_culling && containment != Containment::OUTSIDE ? 
+							intersect(containment, loose_frustum_culling(value)) : containment;
+					}
+				);
+			} else if (win_data.gpu_culling) {
+				gpu_culling.cull(
+					frustum, {{ camera.position_[0], camera.position_[1], camera.position_[2] }}, win_data.view_distance
+				);
+				gpu_culling.draw(assets);
+			} else if (win_data.simulated_mode) {
+				concurrent_tree.read(RENDER_READER, [&](const PseudoQuadTreeType& tree) {
+					if (win_data.frustum_culling) {
+						frustum_culling.depthFirstTraversal(tree, tree_value_action, tree_traversal_predicate);
+					} else {
+						tree.depthFirstTraversal(tree_value_action, tree_traversal_predicate);
+					}
+				});
+			} else if (win_data.cached_culling) {
+				const std::array<float, 4> parameters{{
+					win_data.fov, static_cast<float>(w) / static_cast<float>(h), 
+					win_data.view_distance, win_data.frustum_culling ? 1.F : 0.F
+				}};
+				if (!cached_last_frame || parameters != cached_parameters) {
+					cached_traversal.invalidate();
+					cached_parameters = parameters;
+				}
+				if (!cached_last_frame) {
+					// other modes overwrote the instance buffers
+					for (auto& [model, instances] : cached_instances) {
+						instances.markDirty(0U, instances.offsets.size());
+					}
+				}
+				cached_this_frame = true;
+
+				// camera translation plus how far its rotation moved each of its axes
+				const std::array<const float*, 3> camera_axes{{ 
+					camera.negative_looking_direction_, camera.right_direction_, camera.up_direction_ 
+				}};
+				auto motion = std::hypot(
+					camera.position_[0] - cached_camera_position[0],
+					camera.position_[1] - cached_camera_position[1],
+					camera.position_[2] - cached_camera_position[2]
+				);
+				for (std::size_t axis{0}; axis<3; ++axis) {
+					const auto& cached_axis = cached_camera_axes[axis];
+					motion += CACHED_ROTATION_REACH * std::hypot(
+						camera_axes[axis][0] - cached_axis[0],
+						camera_axes[axis][1] - cached_axis[1],
+						camera_axes[axis][2] - cached_axis[2]
+					);
+					std::copy_n(camera_axes[axis], 3, cached_camera_axes[axis].begin());
+				}
+				std::copy_n(camera.position_, 3, cached_camera_position.begin());
+
+				cached_traversal.update(motion, [&](const PseudoQuadTreeType::TraversalValue& value) {
+					const auto containment = classifyViewDistanceStable(
+						camera.position_[0], camera.position_[2], win_data.view_distance,
+						value.x, value.z, value.area_width, value.area_height
+					);
+					return win_data.frustum_culling ? 
+						intersect(containment, frustum_culling.stableContainment(value, camera.position_, CACHED_ROTATION_REACH)) : 
+						containment;
+				});
+				for (const auto leaf_index : cached_traversal.exited()) {
+					auto& instances = cached_instances[assets[cached_traversal.leaf(leaf_index).value]];
+					const auto slot = cached_slots[leaf_index];
+					const auto last_leaf = instances.leaves.back();
+					instances.offsets[slot] = instances.offsets.back();
+					instances.leaves[slot] = last_leaf;
+					cached_slots[last_leaf] = slot;
+					instances.offsets.pop_back();
+					instances.leaves.pop_back();
+					instances.markDirty(slot, slot + 1U);
+				}
+				for (const auto leaf_index : cached_traversal.entered()) {
+					const auto& leaf = cached_traversal.leaf(leaf_index);
+					auto& instances = cached_instances[assets[leaf.value]];
+					cached_slots[leaf_index] = static_cast<std::uint32_t>(instances.offsets.size());
+					instances.offsets.push_back({leaf.x, 0.F, leaf.z});
+					instances.leaves.push_back(leaf_index);
+					instances.markDirty(instances.offsets.size() - 1U, instances.offsets.size());
+				}
+				if (win_data.instanced_mode) {
+					for (auto& [model, instances] : cached_instances) {
+						const auto dirty_last = std::min(instances.dirty_last, instances.offsets.size());
+						if (instances.dirty_first < dirty_last) {
+							model->sendInstanceData(
+								std::span<const Model::InstanceOffset>(instances.offsets).subspan(
+									instances.dirty_first, dirty_last - instances.dirty_first
+								),
+								static_cast<std::uint32_t>(instances.dirty_first)
+							);
+						}
+						instances.dirty_first = std::numeric_limits<std::size_t>::max();
+						instances.dirty_last = 0U;
+						if (instances.offsets.empty()) {
+							continue;
+						}
+						model->bindInstanced();
+						model->drawInstanced(static_cast<std::uint32_t>(instances.offsets.size()));
+					}
+				} else {
+					for (const auto leaf_index : cached_traversal.visible()) {
+						tree_value_action(cached_traversal.leaf(leaf_index));
+					}
+				}
+			} else if (win_data.parallel_culling) {
+				const auto visible_leaves = win_data.frustum_culling ?
+					parallel_traversal.traverse(
+						quad_tree, 
+						[&](const PseudoQuadTreeType::TraversalValue& value) {
+							return frustum_culling.classifyNode(value, tree_traversal_predicate);
+						},
+						[&](const PseudoQuadTreeType::Subtree& subtree, const auto& leaf_action) {
+							frustum_culling.depthFirstTraversal(quad_tree, subtree, leaf_action, tree_traversal_predicate);
+						}
+					) :
+					parallel_traversal.traverse(quad_tree, tree_traversal_predicate);
+				for (const auto* leaf : visible_leaves) {
+					tree_value_action(*leaf);
+				}
+			} else if (win_data.frustum_culling) {
+				frustum_culling.depthFirstTraversal(quad_tree, tree_value_action, tree_traversal_predicate);
+			} else if (win_data.instanced_mode) {
+				quad_tree.gatherLeaves(
+					instance_batch, assets.size(), instance_group, instance_offset, tree_traversal_predicate
+				);
+			} else {
+				quad_tree.depthFirstTraversal(tree_value_action, tree_traversal_predicate);
+			}
+			cached_last_frame = cached_this_frame;
+			render_queue.submit();
+			instance_batch.finish();
+			for (std::size_t asset_id{0}; asset_id<assets.size(); ++asset_id) {
+				const auto offsets = instance_batch.group(asset_id);
+				if (offsets.empty()) {
+					continue;
+				}
+				auto* model = assets[asset_id];
+				model->sendInstanceData(offsets);
+				model->bindInstanced();
+				model->drawInstanced(static_cast<std::uint32_t>(offsets.size()));
+			}
+
+			const auto gl_calls = GlState::takeCounters();
+			spdlog::debug(
+				"state binds issued {} elided {}, queued draws {}", 
+				gl_calls.issued, gl_calls.elided, render_queue.stats_.draws
+			);
 
+			frame_stream.endFrame();
 			win.swapBuffers();
 			win.pollEvents();
 		}
 
-		ubo.deinit();
+		simulation.request_stop();
+		simulation.join();
+		paged_tree.deinit();
+		thread_pool.deinit();
+		gpu_culling.deinit();
+		frame_stream.deinit();
+		object_buffer.deinit();
 		gun_model.deinit();
 		cube.deinit();
 		win.deinit();
@@ -8,7 +8,8 @@ void rw_cube::setVertexArrayLayout(
     std::uint32_t vao_id,
     std::uint32_t vbo_id,
     std::uint32_t attrib_binding,
-    const std::vector<AttribConfig>& attrib_configs
+    const std::vector<AttribConfig>& attrib_configs,
+    std::uint32_t divisor
 ) {
 	std::int32_t offset{ 0 };
 	for (const auto attrib_config : attrib_configs) {
@@ -20,6 +21,6 @@ void rw_cube::setVertexArrayLayout(
 								   attrib_binding);
 		offset += attrib_config.size_in_dwords * 4;
 	}
-	glVertexArrayBindingDivisor(vao_id, attrib_binding, 0);
+	glVertexArrayBindingDivisor(vao_id, attrib_binding, divisor);
 	glVertexArrayVertexBuffer(vao_id, attrib_binding, vbo_id, 0, offset);
 } 
\ No newline at end of file